@@ -0,0 +1,251 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batchrunner.h"
+#include <QMetaObject>
+#include <QThread>
+#include "commandbuilder.h"
+#include "itemconditions.h"
+
+BatchRunner::BatchRunner(Global* global, QIODevice* input, int max_jobs,
+                         QObject* parent) :
+    QObject(parent),
+    global(global),
+    input(input),
+    maxJobs(max_jobs > 0 ? max_jobs : QThread::idealThreadCount()),
+    inputFormat(INPUTFORMAT_UNKNOWN),
+    inputEnded(false),
+    done(false),
+    recordCount(0),
+    failedCount(0)
+{
+    if(maxJobs < 1)
+        maxJobs = 1;
+}
+
+int BatchRunner::getFailedCount()
+{
+    return failedCount;
+}
+
+void BatchRunner::start()
+{
+    totalTimer.start();
+    startJobs();
+}
+
+/*
+ * read the next record from input into values. The format of the input is
+ * decided by its first non-empty line.
+ */
+enum BatchRunner::RecordStatus BatchRunner::readRecord(
+        QVector<QVariant>* values, QString* error)
+{
+    QString line;
+
+    do
+    {
+        if(input->atEnd())
+            return RECORD_END;
+
+        line = QString::fromUtf8(input->readLine());
+        if(line.endsWith('\n'))
+            line.chop(1);
+        if(line.endsWith('\r'))
+            line.chop(1);
+    }
+    while(line.trimmed().isEmpty());
+
+    if(inputFormat == INPUTFORMAT_UNKNOWN)
+    {
+        if(line.trimmed().startsWith('{'))
+            inputFormat = INPUTFORMAT_JSONL;
+        else
+        {
+            // the first line of TSV input is the keys of the items
+            inputFormat = INPUTFORMAT_TSV;
+            tsvKeys = line.split('\t');
+            return readRecord(values, error);
+        }
+    }
+
+    *values = CommandBuilder::initialValues(*global->getItems());
+
+    if(inputFormat == INPUTFORMAT_JSONL)
+        return CommandBuilder::readValuesJson(
+                    global, line.toUtf8(), values, error) ?
+                    RECORD_OK : RECORD_ERROR;
+
+    const QStringList fields(line.split('\t'));
+    if(fields.count() != tsvKeys.count())
+    {
+        *error = QObject::tr("Expected ") + QString::number(tsvKeys.count()) +
+                QObject::tr(" fields but got ") +
+                QString::number(fields.count());
+        return RECORD_ERROR;
+    }
+
+    QStringList arguments;
+    for(int i = 0; i < fields.count(); ++i)
+        arguments.append(tsvKeys.at(i) + "=" + fields.at(i));
+
+    return CommandBuilder::readValueArguments(
+                global, arguments, values, error) ? RECORD_OK : RECORD_ERROR;
+}
+
+/*
+ * start jobs until maxJobs jobs are running or the input is exhausted
+ */
+void BatchRunner::startJobs()
+{
+    while(!inputEnded && jobs.count() < maxJobs)
+    {
+        QVector<QVariant> values;
+        QString error;
+        enum RecordStatus status = readRecord(&values, &error);
+
+        if(status == RECORD_END)
+        {
+            inputEnded = true;
+            break;
+        }
+
+        int number = ++recordCount;
+
+        if(status == RECORD_ERROR)
+        {
+            reportFailure(number, error);
+            continue;
+        }
+
+        // the items whose conditions are false are left out
+        ItemConditions conditions(global);
+        conditions.setValues(values);
+
+        const Global::Item* empty_item = NULL;
+        QStringList args(CommandBuilder::buildArguments(
+                             *global->getCommand(), *global->getItems(),
+                             values, &empty_item, conditions.getActive()));
+        if(empty_item)
+        {
+            reportFailure(number, QObject::tr("Item \"") + empty_item->key +
+                          QObject::tr("\" must not be empty"));
+            continue;
+        }
+
+        if(args.isEmpty())
+        {
+            reportFailure(number, QObject::tr("Empty command"));
+            continue;
+        }
+
+        QProcess* process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        connect(process, SIGNAL(finished(int,QProcess::ExitStatus)),
+                SLOT(onProcessFinished(int,QProcess::ExitStatus)));
+        connect(process, SIGNAL(error(QProcess::ProcessError)),
+                SLOT(onProcessError(QProcess::ProcessError)));
+
+        Job job;
+        job.number = number;
+        job.command = args.join(" ");
+        job.timer.start();
+        jobs.insert(process, job);
+
+        process->start(args.first(), args.mid(1));
+    }
+
+    if(inputEnded && jobs.isEmpty() && !done)
+    {
+        done = true;
+
+        Global::printText(stderr, QString::number(recordCount) +
+                          QObject::tr(" job(s), ") +
+                          QString::number(failedCount) +
+                          QObject::tr(" failed, ") +
+                          QString::number(totalTimer.elapsed()) +
+                          QObject::tr(" ms in total."));
+
+        Q_EMIT finished();
+    }
+}
+
+void BatchRunner::onProcessFinished(int exit_code,
+                                    QProcess::ExitStatus exit_status)
+{
+    QProcess* process = qobject_cast<QProcess*>(QObject::sender());
+
+    if(!process)
+        return;
+
+    if(exit_status == QProcess::CrashExit)
+        finishJob(process, true, QObject::tr("crashed"));
+    else
+        finishJob(process, exit_code != 0,
+                  QObject::tr("exit code ") + QString::number(exit_code));
+}
+
+void BatchRunner::onProcessError(QProcess::ProcessError error)
+{
+    QProcess* process = qobject_cast<QProcess*>(QObject::sender());
+
+    // finished() is emitted for the other errors
+    if(process && error == QProcess::FailedToStart)
+        finishJob(process, true, QObject::tr("failed to start"));
+}
+
+/*
+ * report the result of a job and start the next ones
+ */
+void BatchRunner::finishJob(QProcess* process, bool failed,
+                            const QString& status)
+{
+    if(!jobs.contains(process))
+        return;
+
+    Job job = jobs.take(process);
+    process->deleteLater();
+
+    if(failed)
+        ++failedCount;
+
+    Global::printText(stderr, QObject::tr("[job ") +
+                      QString::number(job.number) + "] " +
+                      (failed ? QObject::tr("FAILED, ") : QString()) +
+                      status + ", " + QString::number(job.timer.elapsed()) +
+                      QObject::tr(" ms: ") + job.command);
+
+    // start the next jobs from the event loop, so that the signal handlers
+    // of the processes don't nest
+    QMetaObject::invokeMethod(this, "startJobs", Qt::QueuedConnection);
+}
+
+/*
+ * report a record which could not be turned into a command
+ */
+void BatchRunner::reportFailure(int number, const QString& error)
+{
+    ++failedCount;
+
+    Global::printText(stderr, QObject::tr("[job ") + QString::number(number) +
+                      "] " + QObject::tr("FAILED, ") + error);
+}
@@ -0,0 +1,100 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIODevice>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include "global.h"
+
+// this class reads records of item values from input, one record per line,
+// and runs the command assembled from each record. At most maxJobs commands
+// run at the same time. A record is either a JSON object (JSON Lines), or a
+// line of tab separated values whose keys are given by the first line (TSV).
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+public:
+    BatchRunner(Global* global, QIODevice* input, int max_jobs,
+                QObject* parent = 0);
+
+    int getFailedCount();
+
+Q_SIGNALS:
+    // emitted when all records have been run
+    void finished();
+
+public Q_SLOTS:
+    void start();
+
+private:
+    enum RecordStatus
+    {
+        RECORD_OK = 0,
+        RECORD_ERROR,
+        RECORD_END
+    };
+
+    enum InputFormat
+    {
+        INPUTFORMAT_UNKNOWN = 0,
+        INPUTFORMAT_JSONL,
+        INPUTFORMAT_TSV
+    };
+
+    struct Job
+    {
+        int number;
+        QString command;
+        QElapsedTimer timer;
+    };
+
+    Global* global;
+    QIODevice* input;
+    int maxJobs;
+    enum InputFormat inputFormat;
+    QStringList tsvKeys;
+    bool inputEnded;
+    bool done;
+    int recordCount;
+    int failedCount;
+    QHash<QProcess*, Job> jobs;
+    QElapsedTimer totalTimer;
+
+    enum RecordStatus readRecord(QVector<QVariant>* values, QString* error);
+    void finishJob(QProcess* process, bool failed, const QString& status);
+    void reportFailure(int number, const QString& error);
+
+private Q_SLOTS:
+    void startJobs();
+    void onProcessFinished(int exit_code, QProcess::ExitStatus exit_status);
+    void onProcessError(QProcess::ProcessError error);
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,336 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// measure the config load, sorting, window construction, command assembly,
+// resizing and scrolling of CmdLauncher on synthetic cla files of several
+// sizes, and the memory taken by the window
+//
+// Usage: cmdlauncher_bench [iterations] [output json file]
+//        cmdlauncher_bench --generate FILE [items] [tabs] [depth]
+
+#include <QApplication>
+#include <QByteArray>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QScrollBar>
+#include <QStringList>
+#include <QTextStream>
+#include <cstdio>
+#include <cstdlib>
+#include "clagenerator.h"
+#include "commandbuilder.h"
+#include "global.h"
+#include "maintableview.h"
+#include "mainwindow.h"
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+struct Result
+{
+    QString name;
+    int items;
+    int iterations;
+    double meanUs;
+    double minUs;
+};
+
+struct MemoryResult
+{
+    int items;
+    qint64 windowKib; // resident memory taken by the shown window
+};
+
+// state shared by the benchmark functions
+static QString claFile;
+static QList<Global::Item*> sortItems;
+static QVector<QVariant> buildValues;
+static Global* global = NULL;
+static MainWindow* window = NULL;
+static int windowWidth = 800;
+static MainTableView* scrollView = NULL;
+
+static void loadConfig(const QStringList& extra_args)
+{
+    delete global;
+    QStringList args;
+    args << "cmdlauncher" << "-f" << claFile << extra_args;
+    global = new Global(args);
+}
+
+static void benchLoadNoCache()
+{
+    loadConfig(QStringList() << "--no-cache");
+}
+
+static void benchLoadCache()
+{
+    loadConfig(QStringList());
+}
+
+static void benchSort()
+{
+    QList<Global::Item*> items(sortItems);
+    qSort(items.begin(), items.end(), Global::lessThanItemsOrder);
+    qSort(items.begin(), items.end(), Global::lessThanItemsDisplayorder);
+}
+
+static void benchMainWindow()
+{
+    MainWindow* w = new MainWindow(global);
+    w->show();
+    qApp->processEvents();
+    delete w;
+}
+
+static void benchBuild()
+{
+    CommandBuilder::build(*global->getCommand(), *global->getItems(),
+                          buildValues);
+}
+
+static void benchResize()
+{
+    windowWidth = windowWidth == 800 ? 1000 : 800;
+    window->resize(windowWidth, 600);
+    qApp->processEvents();
+}
+
+/*
+ * scroll the visible table by a page, wrapping at the end, and paint it
+ */
+static void benchScroll()
+{
+    QScrollBar* bar = scrollView->verticalScrollBar();
+    int value = bar->value() + bar->pageStep();
+    bar->setValue(value > bar->maximum() ? 0 : value);
+    scrollView->viewport()->repaint();
+}
+
+/*
+ * the resident memory of the process in KiB, 0 if it is unknown
+ */
+static qint64 residentKib()
+{
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/statm");
+    if(!f.open(QIODevice::ReadOnly))
+        return 0;
+
+    QList<QByteArray> fields(f.readAll().split(' '));
+    return fields.value(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+#else
+    return 0;
+#endif
+}
+
+/*
+ * the table of the current tab of the window
+ */
+static MainTableView* findVisibleView(MainWindow* w)
+{
+    Q_FOREACH(MainTableView* view, w->findChildren<MainTableView*>())
+        if(view->isVisible())
+            return view;
+
+    return NULL;
+}
+
+/*
+ * print a line to stderr, without the prefix of Global::printText()
+ */
+static void printLine(const QString& text)
+{
+    QTextStream err(stderr);
+    err << text << endl;
+}
+
+static Result run(const QString& name, int items, int iterations,
+                  void (*func)())
+{
+    Result r;
+    r.name = name;
+    r.items = items;
+    r.iterations = iterations;
+    r.meanUs = 0;
+    r.minUs = 0;
+
+    // warm up
+    func();
+
+    QElapsedTimer timer;
+    qint64 total = 0;
+    qint64 min = -1;
+    for(int i = 0; i < iterations; ++i)
+    {
+        timer.start();
+        func();
+        qint64 t = timer.nsecsElapsed();
+        total += t;
+        if(min < 0 || t < min)
+            min = t;
+    }
+
+    r.meanUs = total / 1000.0 / iterations;
+    r.minUs = min / 1000.0;
+
+    printLine(QString("%1 (%2 items): %3 us")
+              .arg(name).arg(items).arg(r.meanUs, 0, 'f', 1));
+
+    return r;
+}
+
+static int generate(const QStringList& arguments)
+{
+    ClaGenerator::Options opts;
+    QString file(arguments.value(2));
+    if(file.isEmpty())
+    {
+        printLine("--generate requires a file name.");
+        return 1;
+    }
+    opts.items = arguments.value(3, QString::number(opts.items)).toInt();
+    opts.tabs = arguments.value(4, QString::number(opts.tabs)).toInt();
+    opts.depth = arguments.value(5, QString::number(opts.depth)).toInt();
+
+    if(!ClaGenerator::write(file, opts))
+    {
+        printLine("Failed to write " + file + ".");
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QStringList arguments;
+    for(int i = 0; i < argc; ++i)
+        arguments.append(QString::fromLocal8Bit(argv[i]));
+
+    if(arguments.value(1) == "--generate")
+        return generate(arguments);
+
+    // the window is never shown on a screen
+    if(qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication a(argc, argv);
+    int iterations = qMax(arguments.value(1, "10").toInt(), 1);
+    QString output(arguments.value(2));
+
+    QList<Result> results;
+    QList<MemoryResult> memory;
+    static const int sizes[] = { 10, 1000, 10000 };
+
+    for(unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        const int n = sizes[s];
+        ClaGenerator::Options opts;
+        opts.items = n;
+        claFile = QDir::temp().filePath(
+                QString("cmdlauncher_bench_%1.cla").arg(n));
+        if(!ClaGenerator::write(claFile, opts))
+        {
+            printLine("Failed to write " + claFile + ".");
+            return 1;
+        }
+
+        // the largest window is slow to build, run it fewer times
+        const int heavy_iterations = n >= 10000 ?
+            qMax(iterations / 5, 1) : iterations;
+
+        results.append(run("load_no_cache", n, heavy_iterations,
+                           benchLoadNoCache));
+        // the first load writes the cache
+        loadConfig(QStringList() << "--rebuild-cache");
+        results.append(run("load_cache", n, iterations, benchLoadCache));
+
+        sortItems = *global->getItems();
+        results.append(run("sort", n, iterations, benchSort));
+
+        buildValues = CommandBuilder::initialValues(*global->getItems());
+        results.append(run("build_command", n, iterations, benchBuild));
+
+        results.append(run("mainwindow", n, heavy_iterations,
+                           benchMainWindow));
+
+        qint64 rss_before = residentKib();
+        window = new MainWindow(global);
+        window->show();
+        a.processEvents();
+        MemoryResult m;
+        m.items = n;
+        m.windowKib = residentKib() - rss_before;
+        memory.append(m);
+        printLine(QString("window memory (%1 items): %2 KiB")
+                  .arg(n).arg(m.windowKib));
+
+        results.append(run("resize", n, iterations, benchResize));
+
+        scrollView = findVisibleView(window);
+        if(scrollView)
+            results.append(run("scroll", n, iterations, benchScroll));
+        scrollView = NULL;
+        delete window;
+        window = NULL;
+
+        sortItems.clear();
+        delete global;
+        global = NULL;
+        QFile::remove(claFile);
+    }
+
+    QFile f(output);
+    if(output.isEmpty())
+        f.open(stdout, QIODevice::WriteOnly);
+    else if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        printLine("Failed to write " + output + ".");
+        return 1;
+    }
+
+    QTextStream out(&f);
+    out << "{\n  \"benchmarks\": [\n";
+    for(int i = 0; i < results.size(); ++i)
+    {
+        const Result& r = results.at(i);
+        out << "    {\"name\": \"" << r.name << "\", \"items\": " << r.items
+            << ", \"iterations\": " << r.iterations
+            << ", \"mean_us\": " << r.meanUs
+            << ", \"min_us\": " << r.minUs << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ],\n  \"memory\": [\n";
+    for(int i = 0; i < memory.size(); ++i)
+    {
+        const MemoryResult& m = memory.at(i);
+        out << "    {\"items\": " << m.items
+            << ", \"window_kib\": " << m.windowKib << "}"
+            << (i + 1 < memory.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+
+    return 0;
+}
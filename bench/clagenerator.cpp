@@ -0,0 +1,121 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "clagenerator.h"
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+ClaGenerator::Options::Options() :
+    items(1000),
+    tabs(10),
+    listEntries(20),
+    entryLength(32),
+    depth(4)
+{
+}
+
+/*
+ * write a cla file with opts.items items of all types spread on opts.tabs
+ * tabs. Each list item has opts.listEntries entries of opts.entryLength
+ * characters, and each item has an extra mapping nested opts.depth levels
+ * deep, which CmdLauncher does not use but still has to parse.
+ */
+bool ClaGenerator::write(const QString& file,
+                         const ClaGenerator::Options& opts)
+{
+    QFile f(file);
+
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QTextStream out(&f);
+    static const char* types[] = { "bool", "text", "list", "file" };
+
+    QStringList tabs;
+    for(int t = 0; t < opts.tabs; ++t)
+        tabs.append("tab" + QString::number(t));
+
+    out << "general:\n"
+        << "    cmd: echo\n"
+        << "    title: " << opts.items << " items\n"
+        << "    tabs: " << tabs.join(",") << "\n"
+        << "\n"
+        << "items:\n";
+
+    for(int i = 0; i < opts.items; ++i)
+    {
+        const QString type(types[i % 4]);
+
+        out << "    item" << i << ":\n"
+            << "        title: item " << i << " (" << type << ")\n"
+            << "        type: " << type << "\n"
+            << "        tab: tab" << i % qMax(opts.tabs, 1) << "\n"
+            << "        order: " << (opts.items - i) % 97 << "\n"
+            << "        displayorder: " << i % 89 << "\n";
+
+        if(type == "bool")
+            out << "        default: " << i % 2 << "\n"
+                << "        value/yes: --yes" << i << "\n"
+                << "        value/no: --no" << i << "\n";
+        else if(type == "list")
+        {
+            QStringList entries;
+            for(int e = 0; e < opts.listEntries; ++e)
+            {
+                QString entry("entry" + QString::number(e) + "-");
+                entries.append(entry.leftJustified(opts.entryLength, 'x'));
+            }
+
+            out << "        list: " << entries.join(",") << "\n"
+                << "        default: " << i % qMax(opts.listEntries, 1)
+                << "\n";
+            for(int e = 0; e < opts.listEntries; ++e)
+                out << "        value/" << e << ": --list" << i << "=" << e
+                    << "\n";
+        }
+        else
+            out << "        default: value " << i << "\n"
+                << "        value/nonempty: --" << type << i << "=%a\n"
+                << "        value/empty: --no-" << type << i << "\n";
+
+        // nested data
+        if(opts.depth > 0)
+        {
+            out << "        x-meta:\n";
+            QString indent("            ");
+            for(int d = 1; d < opts.depth; ++d)
+            {
+                out << indent << "level" << d << ":\n";
+                indent += "    ";
+            }
+            out << indent << "value: " << i << "\n";
+        }
+    }
+
+    out << "\n"
+        << "about:\n"
+        << "    name: benchmark\n"
+        << "    description: synthetic cla file\n";
+
+    return out.status() == QTextStream::Ok;
+}
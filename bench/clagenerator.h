@@ -0,0 +1,46 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CLAGENERATOR_H
+#define CLAGENERATOR_H
+
+#include <QString>
+
+// write synthetic cla files for benchmarks
+class ClaGenerator
+{
+public:
+    struct Options
+    {
+        int items; // number of items
+        int tabs; // number of tabs
+        int listEntries; // number of entries of each list item
+        int entryLength; // length of each list entry
+        int depth; // nesting depth of the extra data of each item
+
+        Options();
+    };
+
+    static bool write(const QString& file, const ClaGenerator::Options& opts);
+};
+
+#endif // CLAGENERATOR_H
@@ -0,0 +1,73 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// compare the latency of starting a process from a command string with
+// QProcess::startDetached, which is what CmdLauncher used to do, and from an
+// argument vector with Spawner::spawn
+//
+// Usage: cmdlauncher_spawnbench [number of spawns] [program]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QStringList>
+#include <QTextStream>
+#include <cstdio>
+#include <sys/wait.h>
+#include "spawner.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QStringList arguments(a.arguments());
+    int count = arguments.value(1, "200").toInt();
+    QString program(arguments.value(2, "true"));
+    QStringList args;
+    args << program << "--some" << "arguments" << "to pass";
+    QTextStream out(stdout);
+
+    // current path: a command string which Qt splits again
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < count; ++i)
+        QProcess::startDetached(
+                program + " --some arguments \"to pass\"");
+    qint64 qprocess_ns = timer.nsecsElapsed();
+
+    timer.restart();
+    for(int i = 0; i < count; ++i)
+        Spawner::spawn(args);
+    qint64 spawn_ns = timer.nsecsElapsed();
+
+    // reap the children of posix_spawn
+    while(wait(NULL) > 0)
+        ;
+
+    out << "{\n"
+        << "  \"spawns\": " << count << ",\n"
+        << "  \"qprocess_startdetached_us\": "
+        << qprocess_ns / 1000.0 / count << ",\n"
+        << "  \"posix_spawn_us\": " << spawn_ns / 1000.0 / count << "\n"
+        << "}\n";
+
+    return 0;
+}
@@ -0,0 +1,290 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catalog.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QMetaObject>
+#include <QRegExp>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QtAlgorithms>
+#include <yaml-cpp/yaml.h>
+#include "global.h"
+
+// the loading of one cla file, performed on the thread pool
+class CatalogTask : public QRunnable
+{
+public:
+    CatalogTask(Catalog* catalog, Catalog::Entry* entry, int index) :
+        catalog(catalog), entry(entry), index(index)
+    {
+    }
+
+    void run()
+    {
+        Catalog::loadEntry(entry);
+
+        QMetaObject::invokeMethod(catalog, "onEntryLoaded",
+                                  Qt::QueuedConnection, Q_ARG(int, index));
+    }
+
+private:
+    Catalog* catalog;
+    Catalog::Entry* entry;
+    int index;
+};
+
+Catalog::Catalog(QObject* parent) :
+    QObject(parent),
+    loadedCount(0)
+{
+}
+
+Catalog::~Catalog()
+{
+    // the workers write into the entries. The pool is the catalog's own, so
+    // that unrelated tasks of the global pool are not waited for.
+    pool.waitForDone();
+}
+
+/*
+ * find the cla files under dir and load them on the thread pool. The
+ * entries can be used as soon as entryLoaded() is emitted for them.
+ */
+void Catalog::load(const QString& dir)
+{
+    QStringList files;
+    QDirIterator it(dir, QStringList() << "*.cla", QDir::Files,
+                    QDirIterator::Subdirectories |
+                    QDirIterator::FollowSymlinks);
+
+    while(it.hasNext())
+        files.append(it.next());
+    files.sort();
+
+    // the vector is never resized afterwards, so the workers could keep
+    // pointers to the entries
+    entries.resize(files.size());
+    for(int i = 0; i < files.size(); ++i)
+    {
+        entries[i].file = files.at(i);
+        pool.start(new CatalogTask(this, &entries[i], i));
+    }
+
+    if(files.isEmpty())
+        Q_EMIT finished();
+}
+
+/*
+ * read the fields which are searched from a cla file. Runs on a worker
+ * thread, so nothing but entry is touched.
+ */
+void Catalog::loadEntry(Catalog::Entry* entry)
+{
+#define GET_VALUE(section, entry) \
+    (section[entry] && section[entry].IsScalar() ? \
+     QString::fromStdString(section[entry].as<std::string>()) : QString())
+
+    try
+    {
+        YAML::Node config = YAML::LoadFile(entry->file.toUtf8().constData());
+
+        if(config["general"])
+        {
+            YAML::Node config_general = config["general"];
+            entry->title = GET_VALUE(config_general, "title");
+            entry->command = GET_VALUE(config_general, "cmd");
+        }
+
+        if(config["about"] && config["about"].IsMap())
+        {
+            YAML::Node config_about = config["about"];
+            entry->description = GET_VALUE(config_about, "description");
+        }
+
+        if(config["items"] && config["items"].IsMap())
+        {
+            YAML::Node config_items = config["items"];
+            for(YAML::Node::const_iterator item = config_items.begin();
+                item != config_items.end(); ++ item)
+            {
+                if(!item->second.IsMap())
+                    continue;
+
+                QString title(GET_VALUE(item->second, "title"));
+                if(!title.isEmpty())
+                    entry->itemTitles.append(title);
+            }
+        }
+    } catch (YAML::Exception& e)
+    {
+        entry->error = QString::fromLocal8Bit(e.what());
+    }
+
+#undef GET_VALUE
+
+    if(entry->title.isEmpty())
+        entry->title = QFileInfo(entry->file).completeBaseName();
+}
+
+void Catalog::onEntryLoaded(int index)
+{
+    const Entry& entry = entries.at(index);
+
+    if(entry.error.isEmpty())
+    {
+        addToIndex(index, entry.title, WEIGHT_TITLE);
+        addToIndex(index, entry.command, WEIGHT_COMMAND);
+        addToIndex(index, entry.description, WEIGHT_DESCRIPTION);
+        Q_FOREACH(const QString& title, entry.itemTitles)
+            addToIndex(index, title, WEIGHT_ITEM);
+        indexed.append(index);
+    }
+    else
+        Global::printText(stderr, entry.file + ": " + entry.error);
+
+    ++ loadedCount;
+    Q_EMIT entryLoaded(index);
+    if(loadedCount == entries.size())
+        Q_EMIT finished();
+}
+
+void Catalog::addToIndex(int entry, const QString& text, int weight)
+{
+    Q_FOREACH(const QString& token, tokenize(text))
+    {
+        QList<QPair<int, int> >& postings = index[token];
+
+        // a token repeated in the same entry is counted once, with the
+        // highest weight. Entries are indexed one after another, so only the
+        // last posting could be of the same entry.
+        if(!postings.isEmpty() && postings.last().first == entry)
+            postings.last().second = qMax(postings.last().second, weight);
+        else
+            postings.append(qMakePair(entry, weight));
+    }
+}
+
+QStringList Catalog::tokenize(const QString& text)
+{
+    return text.toLower().split(QRegExp("\\W+"), QString::SkipEmptyParts);
+}
+
+int Catalog::getCount()
+{
+    return entries.size();
+}
+
+int Catalog::getLoadedCount()
+{
+    return loadedCount;
+}
+
+const Catalog::Entry* Catalog::getEntry(int index)
+{
+    return &entries.at(index);
+}
+
+// sort by score, highest first, then by title
+class ResultsLessThan
+{
+public:
+    ResultsLessThan(const QHash<int, int>& scores,
+                    const QVector<Catalog::Entry>& entries) :
+        scores(scores), entries(entries)
+    {
+    }
+
+    bool operator()(int e1, int e2) const
+    {
+        int s1 = scores.value(e1);
+        int s2 = scores.value(e2);
+
+        if(s1 != s2)
+            return s1 > s2;
+
+        return QString::localeAwareCompare(entries.at(e1).title,
+                                           entries.at(e2).title) < 0;
+    }
+
+private:
+    const QHash<int, int>& scores;
+    const QVector<Catalog::Entry>& entries;
+};
+
+/*
+ * the indexes of the loaded entries matching every word of query, a word
+ * matching the beginning of any word of the entry. An empty query matches
+ * all loaded entries.
+ */
+QList<int> Catalog::search(const QString& query)
+{
+    QStringList words(tokenize(query));
+    QHash<int, int> scores;
+
+    if(words.isEmpty())
+        Q_FOREACH(int i, indexed)
+            scores.insert(i, 0);
+
+    for(int w = 0; w < words.size(); ++w)
+    {
+        // the best weight of each entry for this word
+        QHash<int, int> word_scores;
+        const QString& word = words.at(w);
+        QMap<QString, QList<QPair<int, int> > >::const_iterator it =
+            index.lowerBound(word);
+
+        for(; it != index.constEnd() && it.key().startsWith(word); ++it)
+        {
+            for(int p = 0; p < it.value().size(); ++p)
+            {
+                const QPair<int, int>& posting = it.value().at(p);
+                int& score = word_scores[posting.first];
+                score = qMax(score, posting.second);
+            }
+        }
+
+        // keep the entries matching all the words so far
+        if(w == 0)
+            scores = word_scores;
+        else
+        {
+            QHash<int, int> matched;
+            for(QHash<int, int>::const_iterator s = scores.constBegin();
+                s != scores.constEnd(); ++s)
+                if(word_scores.contains(s.key()))
+                    matched.insert(s.key(),
+                                   s.value() + word_scores.value(s.key()));
+            scores = matched;
+        }
+
+        if(scores.isEmpty())
+            break;
+    }
+
+    QList<int> results(scores.keys());
+    qSort(results.begin(), results.end(), ResultsLessThan(scores, entries));
+
+    return results;
+}
@@ -0,0 +1,100 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+// all cla files under a directory tree, loaded in parallel on a thread
+// pool, with a search index over their titles, commands, descriptions and
+// item titles
+class Catalog : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry
+    {
+        QString file;
+        QString title;
+        QString command;
+        QString description;
+        QStringList itemTitles;
+        QString error; // not empty if the file could not be parsed
+    };
+
+    Catalog(QObject* parent = 0);
+    ~Catalog();
+
+    void load(const QString& dir);
+    int getCount();
+    int getLoadedCount();
+    const Catalog::Entry* getEntry(int index);
+    QList<int> search(const QString& query);
+
+    static void loadEntry(Catalog::Entry* entry);
+
+Q_SIGNALS:
+    // emitted in the GUI thread when an entry has been loaded
+    void entryLoaded(int index);
+    // emitted when all entries have been loaded
+    void finished();
+
+private Q_SLOTS:
+    void onEntryLoaded(int index);
+
+private:
+    // how much a match in each field counts in the search results
+    enum Weight
+    {
+        WEIGHT_ITEM = 1,
+        WEIGHT_DESCRIPTION = 1,
+        WEIGHT_COMMAND = 2,
+        WEIGHT_TITLE = 4
+    };
+
+    // the entries are allocated before loading starts, each worker fills
+    // its own entry
+    QVector<Catalog::Entry> entries;
+    // the files are loaded on a pool of their own, see ~Catalog()
+    QThreadPool pool;
+    int loadedCount;
+    // the entries which have been loaded without error, in loading order
+    QList<int> indexed;
+
+    // lowercase token -> (entry index, weight). A QMap, so that the tokens
+    // starting with a prefix are next to each other.
+    QMap<QString, QList<QPair<int, int> > > index;
+
+    void addToIndex(int entry, const QString& text, int weight);
+
+    static QStringList tokenize(const QString& text);
+};
+
+#endif // CATALOG_H
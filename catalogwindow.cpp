@@ -0,0 +1,124 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "catalogwindow.h"
+#include <QDir>
+#include <QVBoxLayout>
+
+CatalogWindow::CatalogWindow(const QString& dir,
+                             const QStringList& arguments,
+                             QWidget* parent) :
+    QWidget(parent),
+    arguments(arguments)
+{
+    setWindowTitle(QDir(dir).dirName() + "  --  " +
+                   QObject::tr("CmdLauncher"));
+    resize(600, 500);
+
+    ui.searchLineEdit = new QLineEdit(this);
+    ui.searchLineEdit->setPlaceholderText(QObject::tr("Search"));
+    ui.resultListWidget = new QListWidget(this);
+    ui.resultListWidget->setUniformItemSizes(true);
+    ui.statusLabel = new QLabel(this);
+
+    QVBoxLayout* main_layout = new QVBoxLayout(this);
+    main_layout->addWidget(ui.searchLineEdit);
+    main_layout->addWidget(ui.resultListWidget);
+    main_layout->addWidget(ui.statusLabel);
+    setLayout(main_layout);
+
+    catalog = new Catalog(this);
+    launcher = new LauncherDaemon(this);
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(REFRESH_INTERVAL);
+
+    connect(ui.searchLineEdit, SIGNAL(textChanged(QString)),
+            SLOT(refresh()));
+    connect(ui.searchLineEdit, SIGNAL(returnPressed()),
+            SLOT(onSearchReturnPressed()));
+    connect(ui.resultListWidget, SIGNAL(itemActivated(QListWidgetItem*)),
+            SLOT(onResultActivated(QListWidgetItem*)));
+    connect(catalog, SIGNAL(entryLoaded(int)), SLOT(onEntryLoaded()));
+    connect(catalog, SIGNAL(finished()), SLOT(refresh()));
+    connect(refreshTimer, SIGNAL(timeout()), SLOT(refresh()));
+
+    catalog->load(dir);
+    refresh();
+}
+
+/*
+ * show the entries matching the search text
+ */
+void CatalogWindow::refresh()
+{
+    refreshTimer->stop();
+
+    QList<int> results(catalog->search(ui.searchLineEdit->text()));
+
+    ui.resultListWidget->clear();
+    Q_FOREACH(int index, results)
+    {
+        const Catalog::Entry* entry = catalog->getEntry(index);
+        QListWidgetItem* item = new QListWidgetItem(entry->title);
+        item->setToolTip(entry->file + "\n" + entry->description);
+        item->setData(Qt::UserRole, entry->file);
+        ui.resultListWidget->addItem(item);
+    }
+    if(!results.isEmpty())
+        ui.resultListWidget->setCurrentRow(0);
+
+    if(catalog->getLoadedCount() < catalog->getCount())
+        ui.statusLabel->setText(QObject::tr("Loading %1 of %2 files...")
+                                .arg(catalog->getLoadedCount())
+                                .arg(catalog->getCount()));
+    else
+        ui.statusLabel->setText(QObject::tr("%1 of %2 files")
+                                .arg(results.size())
+                                .arg(catalog->getCount()));
+}
+
+void CatalogWindow::onEntryLoaded()
+{
+    if(!refreshTimer->isActive())
+        refreshTimer->start();
+}
+
+void CatalogWindow::onResultActivated(QListWidgetItem* item)
+{
+    QStringList window_arguments(arguments);
+    window_arguments << "-f" << item->data(Qt::UserRole).toString();
+
+    launcher->openWindow(QDir::currentPath(), window_arguments);
+}
+
+/*
+ * open the selected result when return is pressed in the search box
+ */
+void CatalogWindow::onSearchReturnPressed()
+{
+    QListWidgetItem* item = ui.resultListWidget->currentItem();
+
+    if(item)
+        onResultActivated(item);
+}
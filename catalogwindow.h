@@ -0,0 +1,68 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CATALOGWINDOW_H
+#define CATALOGWINDOW_H
+
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QStringList>
+#include <QTimer>
+#include <QWidget>
+#include "catalog.h"
+#include "launcherdaemon.h"
+
+// the window of --catalog: search the cla files of a directory tree and open
+// the main window of the chosen one
+class CatalogWindow : public QWidget
+{
+    Q_OBJECT
+public:
+    CatalogWindow(const QString& dir, const QStringList& arguments,
+                  QWidget* parent = NULL);
+
+private:
+    struct UI
+    {
+        QLineEdit*   searchLineEdit;
+        QListWidget* resultListWidget;
+        QLabel*      statusLabel;
+    } ui;
+
+    Catalog* catalog;
+    // opens the main windows and keeps the loaded cla files
+    LauncherDaemon* launcher;
+    // arguments given to the main windows, without the cla file
+    QStringList arguments;
+    // refreshes the results at most every REFRESH_INTERVAL ms while loading
+    QTimer* refreshTimer;
+    static const int REFRESH_INTERVAL = 100;
+
+private Q_SLOTS:
+    void refresh();
+    void onEntryLoaded();
+    void onResultActivated(QListWidgetItem* item);
+    void onSearchReturnPressed();
+};
+
+#endif // CATALOGWINDOW_H
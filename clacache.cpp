@@ -0,0 +1,187 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "clacache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include "global.h"
+
+// bump CACHE_VERSION whenever the layout of the cache changes
+static const quint32 CACHE_MAGIC = 0x434c4143; // "CLAC"
+static const quint32 CACHE_VERSION = 7;
+
+/*
+ * fill global with the cached content of conf_file. Return false if there is
+ * no valid cache for conf_file, in which case global is left untouched.
+ */
+bool ClaCache::read(const QString& conf_file, Global* global)
+{
+    QFileInfo fi(conf_file);
+    QFile f(getCacheFile(conf_file));
+
+    if(!f.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 size = f.size();
+    uchar* data = f.map(0, size);
+    if(!data)
+        return false;
+
+    QByteArray raw(QByteArray::fromRawData(
+                       reinterpret_cast<const char*>(data), size));
+    QDataStream in(raw);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    // check whether the cache belongs to the current conf_file
+    quint32 magic = 0, version = 0;
+    QString path;
+    qint64 mtime = 0, file_size = 0;
+    QByteArray hash;
+
+    in >> magic >> version;
+    if(magic != CACHE_MAGIC || version != CACHE_VERSION)
+        return false;
+
+    in >> path >> mtime >> file_size;
+    if(in.status() != QDataStream::Ok ||
+            path != fi.absoluteFilePath() ||
+            mtime != fi.lastModified().toMSecsSinceEpoch() ||
+            file_size != fi.size())
+        return false;
+
+    in >> hash;
+    if(in.status() != QDataStream::Ok || hash != hashFile(conf_file))
+        return false;
+
+    // read everything into temporary variables first, so that global is not
+    // touched if the cache turns out to be truncated
+    QString command, window_title, geometry;
+    Spawner::Redirections redirections;
+    QStringList tabs;
+    quint32 item_count = 0;
+    QList<Global::Item> items;
+    QList<Global::Terminal> terminals;
+    Global::About about;
+
+    in >> command >> window_title >> tabs >> geometry
+        >> redirections.stdinFile >> redirections.stdoutFile
+        >> redirections.stderrFile >> item_count;
+    for(quint32 i = 0; i < item_count && in.status() == QDataStream::Ok; ++i)
+    {
+        Global::Item item;
+        in >> item;
+        items.append(item);
+    }
+    in >> terminals;
+    in >> about.name >> about.version >> about.description >> about.authors
+        >> about.url >> about.pixmapFile;
+
+    if(in.status() != QDataStream::Ok)
+        return false;
+
+    global->command = command;
+    global->windowTitle = window_title;
+    global->tabs = tabs;
+    global->claGeometry = geometry;
+    global->redirections = redirections;
+    Q_FOREACH(const Global::Item& item, items)
+        global->items.append(new Global::Item(item));
+    global->claTerminals = terminals;
+    global->about = about;
+
+    return true;
+}
+
+/*
+ * write the parsed content of conf_file held by global to the cache
+ */
+bool ClaCache::write(const QString& conf_file, const Global* global)
+{
+    QFileInfo fi(conf_file);
+    QString cache_file(getCacheFile(conf_file));
+
+    if(!QDir().mkpath(QFileInfo(cache_file).absolutePath()))
+        return false;
+
+    QSaveFile f(cache_file);
+    if(!f.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << CACHE_MAGIC << CACHE_VERSION;
+    out << fi.absoluteFilePath()
+        << fi.lastModified().toMSecsSinceEpoch()
+        << fi.size()
+        << hashFile(conf_file);
+
+    out << global->command << global->windowTitle << global->tabs
+        << global->claGeometry
+        << global->redirections.stdinFile << global->redirections.stdoutFile
+        << global->redirections.stderrFile;
+
+    out << quint32(global->items.count());
+    Q_FOREACH(const Global::Item* item, global->items)
+        out << *item;
+
+    out << global->claTerminals;
+
+    const Global::About& about = global->about;
+    out << about.name << about.version << about.description << about.authors
+        << about.url << about.pixmapFile;
+
+    return out.status() == QDataStream::Ok && f.commit();
+}
+
+/*
+ * get the path of the cache file for conf_file
+ */
+QString ClaCache::getCacheFile(const QString& conf_file)
+{
+    QByteArray key(QCryptographicHash::hash(
+                       QFileInfo(conf_file).absoluteFilePath().toUtf8(),
+                       QCryptographicHash::Sha1).toHex());
+
+    return QStandardPaths::writableLocation(
+                QStandardPaths::GenericCacheLocation) +
+            "/cmdlauncher/" + QString::fromLatin1(key) + ".clc";
+}
+
+QByteArray ClaCache::hashFile(const QString& conf_file)
+{
+    QFile f(conf_file);
+    if(!f.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(&f);
+
+    return hash.result();
+}
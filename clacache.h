@@ -0,0 +1,46 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CLACACHE_H
+#define CLACACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+class Global;
+
+// binary cache of parsed cla files, so that yaml-cpp does not need to be
+// involved when a cla file has not changed since it was last loaded. A cache
+// is only used when the path, the modification time, the size and the content
+// hash of the cla file all match the ones stored in it.
+class ClaCache
+{
+public:
+    static bool read(const QString& conf_file, Global* global);
+    static bool write(const QString& conf_file, const Global* global);
+    static QString getCacheFile(const QString& conf_file);
+
+private:
+    static QByteArray hashFile(const QString& conf_file);
+};
+
+#endif // CLACACHE_H
@@ -0,0 +1,358 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "commandbuilder.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QObject>
+
+/*
+ * select the template used for value of item, and set arg to the text
+ * substituted into the template. Return NULL if no template is used.
+ */
+static const ValueTemplate* selectTemplate(const Global::Item* item,
+                                           const QVariant& value,
+                                           QString* arg)
+{
+    switch(item->type)
+    {
+    case Global::Item::TYPE_BOOL:
+        // bool type, if set to true, then use "value/yes", otherwise use
+        // "value/no"
+        return value.toBool() ? &item->yesTemplate : &item->noTemplate;
+    case Global::Item::TYPE_TEXT:
+    case Global::Item::TYPE_FILE:
+        // text and file type, if it is empty, use "value/empty", otherwise
+        // use "value/nonempty" with the text substituted
+        *arg = value.toString();
+        return arg->isEmpty() ? &item->emptyTemplate :
+                                &item->nonemptyTemplate;
+    case Global::Item::TYPE_LIST:
+    {
+        // list type, use "value/n", n is the selected index. The entry is
+        // substituted into the templates of "list-cmd" items.
+        int index = value.toInt();
+        if(index < 0 || index >= item->listTemplates.count())
+            return NULL;
+        *arg = item->list.value(index);
+        return &item->listTemplates.at(index);
+    }
+    default:
+        return NULL;
+    }
+}
+
+/*
+ * whether item must not be empty but value is empty
+ */
+static bool isMissing(const Global::Item* item, const QVariant& value)
+{
+    return item->mustNotEmpty &&
+            (item->type == Global::Item::TYPE_TEXT ||
+             item->type == Global::Item::TYPE_FILE) &&
+            value.toString().isEmpty();
+}
+
+/*
+ * append the string which value of item contributes to the final command to
+ * out, not including the separating space. File names are quoted. Return
+ * false if item must not be empty but value is empty.
+ */
+bool CommandBuilder::appendFragment(QString* out, const Global::Item* item,
+                                    const QVariant& value)
+{
+    if(isMissing(item, value))
+        return false;
+
+    QString arg;
+    const ValueTemplate* t = selectTemplate(item, value, &arg);
+
+    if(t)
+        t->appendTo(out, arg, item->type == Global::Item::TYPE_FILE);
+
+    return true;
+}
+
+/*
+ * append the arguments which value of item contributes to the final command
+ * to out. Return false if item must not be empty but value is empty.
+ */
+bool CommandBuilder::appendFragmentArguments(QStringList* out,
+                                             const Global::Item* item,
+                                             const QVariant& value)
+{
+    if(isMissing(item, value))
+        return false;
+
+    QString arg;
+    const ValueTemplate* t = selectTemplate(item, value, &arg);
+
+    if(t)
+        t->appendArguments(out, arg);
+
+    return true;
+}
+
+/*
+ * whether item is left out of the command because its conditions are false
+ */
+static bool isInactive(const Global::Item* item, const QBitArray* active)
+{
+    return active && !active->testBit(item->number);
+}
+
+/*
+ * figure out the final command. If an item which must not be empty is empty,
+ * return a null string and set empty_item to the item. If active is given,
+ * only the items set in it are used, see ItemConditions.
+ */
+QString CommandBuilder::build(const QString& command,
+                              const QList<Global::Item*>& items,
+                              const QVector<QVariant>& values,
+                              const Global::Item** empty_item,
+                              const QBitArray* active)
+{
+    int count = items.count();
+
+    // reserve the memory first, so that the command is assembled without
+    // reallocation in most cases
+    int capacity = command.size();
+    for(int i = 0; i < count; ++i)
+    {
+        const Global::Item* item = items.at(i);
+        if(isInactive(item, active))
+            continue;
+
+        QString arg;
+        const ValueTemplate* t = selectTemplate(
+                    item, values.value(item->number), &arg);
+
+        capacity += 1 + (t ? t->sizeHint(arg) : 0);
+    }
+
+    QString final_cmd;
+    final_cmd.reserve(capacity);
+    final_cmd += command;
+
+    for(int i = 0; i < count; ++i)
+    {
+        const Global::Item* item = items.at(i);
+
+        if(item->type == Global::Item::TYPE_UNKNOWN ||
+                isInactive(item, active))
+            continue;
+
+        final_cmd += ' ';
+        if(!appendFragment(&final_cmd, item, values.value(item->number)))
+        {
+            if(empty_item)
+                *empty_item = item;
+
+            return QString();
+        }
+    }
+
+    return final_cmd;
+}
+
+/*
+ * figure out the arguments of the final command. Unlike splitting the result
+ * of build(), the text of text and file items is never split, e.g. a file
+ * name containing spaces stays one argument. If an item which must not be
+ * empty is empty, return an empty list and set empty_item to the item. If
+ * active is given, only the items set in it are used.
+ */
+QStringList CommandBuilder::buildArguments(const QString& command,
+                                           const QList<Global::Item*>& items,
+                                           const QVector<QVariant>& values,
+                                           const Global::Item** empty_item,
+                                           const QBitArray* active)
+{
+    QStringList args(splitCommand(command));
+    int count = items.count();
+
+    for(int i = 0; i < count; ++i)
+    {
+        const Global::Item* item = items.at(i);
+
+        if(isInactive(item, active))
+            continue;
+
+        if(!appendFragmentArguments(&args, item, values.value(item->number)))
+        {
+            if(empty_item)
+                *empty_item = item;
+
+            return QStringList();
+        }
+    }
+
+    return args;
+}
+
+/*
+ * split command into arguments the same way as QProcess::startDetached does:
+ * arguments are separated by spaces, double quotes group an argument and
+ * three consecutive double quotes represent a double quote
+ */
+QStringList CommandBuilder::splitCommand(const QString& command)
+{
+    QStringList args;
+    QString tmp;
+    int quote_count = 0;
+    bool in_quote = false;
+
+    for(int i = 0; i < command.size(); ++i)
+    {
+        const QChar c = command.at(i);
+
+        if(c == '"')
+        {
+            ++quote_count;
+            if(quote_count == 3)
+            {
+                quote_count = 0;
+                tmp += c;
+            }
+            continue;
+        }
+
+        if(quote_count)
+        {
+            if(quote_count == 1)
+                in_quote = !in_quote;
+            quote_count = 0;
+        }
+
+        if(!in_quote && c.isSpace())
+        {
+            if(!tmp.isEmpty())
+            {
+                args.append(tmp);
+                tmp.clear();
+            }
+        }
+        else
+            tmp += c;
+    }
+
+    if(!tmp.isEmpty())
+        args.append(tmp);
+
+    return args;
+}
+
+/*
+ * the values of all items before they are changed
+ */
+QVector<QVariant> CommandBuilder::initialValues(
+        const QList<Global::Item*>& items)
+{
+    QVector<QVariant> values(items.count());
+
+    Q_FOREACH(const Global::Item* item, items)
+        values[item->number] = item->initialValue();
+
+    return values;
+}
+
+/*
+ * read values given as "key=value"
+ */
+bool CommandBuilder::readValueArguments(Global* global,
+                                        const QStringList& arguments,
+                                        QVector<QVariant>* values,
+                                        QString* error)
+{
+    Q_FOREACH(const QString& arg, arguments)
+    {
+        int pos = arg.indexOf('=');
+
+        if(pos < 0)
+        {
+            *error = QObject::tr("Value \"") + arg +
+                    QObject::tr("\" is not in the form of KEY=VALUE");
+            return false;
+        }
+
+        if(!setValue(global, arg.left(pos), arg.mid(pos + 1), values, error))
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * read values from a JSON object whose keys are the keys of the items
+ */
+bool CommandBuilder::readValuesJson(Global* global, const QByteArray& json,
+                                    QVector<QVariant>* values,
+                                    QString* error)
+{
+    QJsonParseError parse_error;
+    QJsonDocument doc(QJsonDocument::fromJson(json, &parse_error));
+
+    if(parse_error.error != QJsonParseError::NoError || !doc.isObject())
+    {
+        *error = QObject::tr("Invalid JSON object: ") +
+                parse_error.errorString();
+        return false;
+    }
+
+    const QJsonObject obj(doc.object());
+    for(QJsonObject::const_iterator it = obj.begin(); it != obj.end(); ++it)
+    {
+        // JSON booleans and numbers are converted to "true", "false" and the
+        // number, which are understood by Global::Item::valueFromString
+        if(!setValue(global, it.key(), it.value().toVariant().toString(),
+                     values, error))
+            return false;
+    }
+
+    return true;
+}
+
+bool CommandBuilder::setValue(Global* global, const QString& key,
+                              const QString& value, QVector<QVariant>* values,
+                              QString* error)
+{
+    const Global::Item* item = global->getItem(key);
+
+    if(!item)
+    {
+        *error = QObject::tr("Unknown item \"") + key + "\"";
+        return false;
+    }
+
+    QVariant v(item->valueFromString(value));
+    if(!v.isValid())
+    {
+        *error = QObject::tr("Invalid value \"") + value +
+                QObject::tr("\" for item \"") + key + "\"";
+        return false;
+    }
+
+    (*values)[item->number] = v;
+
+    return true;
+}
@@ -0,0 +1,71 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMMANDBUILDER_H
+#define COMMANDBUILDER_H
+
+#include <QBitArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include "global.h"
+
+// assemble the final command from the values of the items. This class does
+// not depend on any widget, so that it can be used without the main window.
+// The values are indexed by Global::Item::number, in the form returned by
+// Global::Item::initialValue().
+class CommandBuilder
+{
+public:
+    static QString build(const QString& command,
+                         const QList<Global::Item*>& items,
+                         const QVector<QVariant>& values,
+                         const Global::Item** empty_item = NULL,
+                         const QBitArray* active = NULL);
+    static QStringList buildArguments(const QString& command,
+                                      const QList<Global::Item*>& items,
+                                      const QVector<QVariant>& values,
+                                      const Global::Item** empty_item = NULL,
+                                      const QBitArray* active = NULL);
+    static bool appendFragment(QString* out, const Global::Item* item,
+                               const QVariant& value);
+    static bool appendFragmentArguments(QStringList* out,
+                                        const Global::Item* item,
+                                        const QVariant& value);
+    static QStringList splitCommand(const QString& command);
+    static QVector<QVariant> initialValues(const QList<Global::Item*>& items);
+    static bool readValueArguments(Global* global,
+                                   const QStringList& arguments,
+                                   QVector<QVariant>* values,
+                                   QString* error);
+    static bool readValuesJson(Global* global, const QByteArray& json,
+                               QVector<QVariant>* values, QString* error);
+
+private:
+    static bool setValue(Global* global, const QString& key,
+                         const QString& value, QVector<QVariant>* values,
+                         QString* error);
+};
+
+#endif // COMMANDBUILDER_H
@@ -0,0 +1,182 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "commandpreview.h"
+#include <QFontDatabase>
+#include <QTextCursor>
+#include <QtAlgorithms>
+#include "commandbuilder.h"
+
+CommandPreview::CommandPreview(const QString& command,
+                               const QList<Global::Item*>* items,
+                               QWidget* parent) :
+    QPlainTextEdit(parent),
+    command(command),
+    items(items),
+    active(NULL)
+{
+    setReadOnly(true);
+    // the fragments are replaced in the document, which must not keep them
+    setUndoRedoEnabled(false);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setMaximumHeight(fontMetrics().lineSpacing() * 4);
+
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(DEBOUNCE_DELAY);
+    connect(&debounceTimer, SIGNAL(timeout()), SLOT(flush()));
+}
+
+/*
+ * change the command the fragments are appended to. It is displayed by the
+ * next call to setValues().
+ */
+void CommandPreview::setCommand(const QString& command)
+{
+    this->command = command;
+}
+
+/*
+ * only show the fragments of the items set in active, see ItemConditions.
+ * The change is displayed when the values are set again.
+ */
+void CommandPreview::setActive(const QBitArray* active)
+{
+    this->active = active;
+}
+
+/*
+ * render the whole command from values, which are indexed by
+ * Global::Item::number
+ */
+void CommandPreview::setValues(const QVector<QVariant>& values)
+{
+    int count = items->count();
+
+    fragments.resize(count);
+    offsets.resize(count);
+    pendingValues.resize(count);
+    pendingNumbers.clear();
+    debounceTimer.stop();
+
+    text = command;
+    for(int i = 0; i < count; ++i)
+    {
+        const Global::Item* item = items->at(i);
+
+        fragments[i] = renderFragment(item, values.value(item->number));
+        offsets[i] = text.size();
+        text += fragments[i];
+    }
+
+    setPlainText(text);
+}
+
+/*
+ * update the fragment of the item whose number is number. If debounce is
+ * true, the update is delayed until no change has been made for a while,
+ * which is used while the user is typing.
+ */
+void CommandPreview::setValue(int number, const QVariant& value,
+                              bool debounce)
+{
+    if(number < 0 || number >= fragments.count())
+        return;
+
+    pendingValues[number] = value;
+    if(!pendingNumbers.contains(number))
+        pendingNumbers.append(number);
+
+    if(debounce)
+        debounceTimer.start();
+    else
+        flush();
+}
+
+/*
+ * render the fragments of the changed items and splice them into the cached
+ * command and into the document. Only the changed ranges of the document are
+ * replaced, so that the selection and the scroll position of the user are
+ * kept.
+ */
+void CommandPreview::flush()
+{
+    debounceTimer.stop();
+
+    if(pendingNumbers.isEmpty())
+        return;
+
+    // the fragments are replaced from the last one, so that the offsets of
+    // the ones before are still those in the document
+    qSort(pendingNumbers.begin(), pendingNumbers.end(), qGreater<int>());
+
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+    Q_FOREACH(int number, pendingNumbers)
+    {
+        const QString fragment(renderFragment(items->at(number),
+                                              pendingValues.at(number)));
+        int old_size = fragments.at(number).size();
+        int delta = fragment.size() - old_size;
+
+        if(fragment != fragments.at(number))
+        {
+            cursor.setPosition(offsets.at(number));
+            cursor.setPosition(offsets.at(number) + old_size,
+                               QTextCursor::KeepAnchor);
+            cursor.insertText(fragment);
+        }
+
+        text.replace(offsets.at(number), old_size, fragment);
+        fragments[number] = fragment;
+        pendingValues[number] = QVariant();
+
+        if(delta == 0)
+            continue;
+
+        // the fragments after the changed one are moved
+        int count = offsets.count();
+        for(int i = number + 1; i < count; ++i)
+            offsets[i] += delta;
+    }
+    pendingNumbers.clear();
+    cursor.endEditBlock();
+}
+
+/*
+ * the fragment of the command contributed by item, including the separating
+ * space. Items which must not be empty but are empty are shown by title.
+ */
+QString CommandPreview::renderFragment(const Global::Item* item,
+                                       const QVariant& value)
+{
+    if(item->type == Global::Item::TYPE_UNKNOWN)
+        return QString();
+    if(active && item->number < active->size() &&
+            !active->testBit(item->number))
+        return QString();
+
+    QString fragment(" ");
+    if(!CommandBuilder::appendFragment(&fragment, item, value))
+        fragment += "<" + item->title + ">";
+
+    return fragment;
+}
@@ -0,0 +1,74 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMMANDPREVIEW_H
+#define COMMANDPREVIEW_H
+
+#include <QBitArray>
+#include <QList>
+#include <QPlainTextEdit>
+#include <QString>
+#include <QTimer>
+#include <QVariant>
+#include <QVector>
+#include "global.h"
+
+// this class displays the final command while the values of the items are
+// being changed. The fragment of the command contributed by each item is
+// cached, so that when the value of an item changes, only the fragment of
+// that item is rendered again and spliced into the cached command.
+class CommandPreview : public QPlainTextEdit
+{
+    Q_OBJECT
+public:
+    CommandPreview(const QString& command, const QList<Global::Item*>* items,
+                   QWidget* parent = 0);
+
+    void setCommand(const QString& command);
+    void setActive(const QBitArray* active);
+    void setValues(const QVector<QVariant>& values);
+    void setValue(int number, const QVariant& value, bool debounce = false);
+
+private:
+    // delay of the update after a debounced change, in milliseconds
+    static const int DEBOUNCE_DELAY = 150;
+
+    QString command;
+    const QList<Global::Item*>* items;
+    // the items used in the command, all if NULL
+    const QBitArray* active;
+
+    QString text; // the cached command
+    QVector<QString> fragments; // indexed by Global::Item::number
+    QVector<int> offsets; // the position of each fragment in text
+
+    QVector<QVariant> pendingValues;
+    QVector<int> pendingNumbers;
+    QTimer debounceTimer;
+
+    QString renderFragment(const Global::Item* item, const QVariant& value);
+
+private Q_SLOTS:
+    void flush();
+};
+
+#endif // COMMANDPREVIEW_H
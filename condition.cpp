@@ -0,0 +1,412 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "condition.h"
+#include <QObject>
+#include <QVarLengthArray>
+
+// the recursive descent parser of a condition, which appends the tokens of
+// the expression to the program in reverse Polish notation
+class ConditionParser
+{
+public:
+    ConditionParser(const QString& source, const QHash<QString, int>& numbers,
+                    Condition* condition) :
+        source(source), numbers(numbers), condition(condition), pos(0)
+    {
+    }
+
+    bool parse(QString* error)
+    {
+        if(!parseOr())
+        {
+            *error = this->error;
+            return false;
+        }
+
+        skipSpaces();
+        if(pos < source.size())
+        {
+            *error = QObject::tr("unexpected \"") + source.mid(pos) + "\"";
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    const QString& source;
+    const QHash<QString, int>& numbers;
+    Condition* condition;
+    int pos;
+    QString error;
+
+    void skipSpaces()
+    {
+        while(pos < source.size() && source.at(pos).isSpace())
+            ++pos;
+    }
+
+    // consume str if it is next
+    bool accept(const char* str)
+    {
+        skipSpaces();
+
+        QLatin1String s(str);
+        if(!source.midRef(pos).startsWith(s))
+            return false;
+
+        pos += s.size();
+        return true;
+    }
+
+    void appendOperator(enum Condition::Token::Kind kind)
+    {
+        Condition::Token token;
+        token.kind = kind;
+        token.number = -1;
+        condition->program.append(token);
+    }
+
+    bool parseOr()
+    {
+        if(!parseAnd())
+            return false;
+
+        while(accept("||"))
+        {
+            if(!parseAnd())
+                return false;
+            appendOperator(Condition::Token::KIND_OR);
+        }
+
+        return true;
+    }
+
+    bool parseAnd()
+    {
+        if(!parseNot())
+            return false;
+
+        while(accept("&&"))
+        {
+            if(!parseNot())
+                return false;
+            appendOperator(Condition::Token::KIND_AND);
+        }
+
+        return true;
+    }
+
+    bool parseNot()
+    {
+        // "!=" is not a negation, but it can't start an operand either
+        if(accept("!"))
+        {
+            if(!parseNot())
+                return false;
+            appendOperator(Condition::Token::KIND_NOT);
+            return true;
+        }
+
+        return parseCompare();
+    }
+
+    bool parseCompare()
+    {
+        if(!parseOperand())
+            return false;
+
+        // the longer operators first
+        static const struct
+        {
+            const char* op;
+            enum Condition::Token::Kind kind;
+        } operators[] = {
+            { "==", Condition::Token::KIND_EQ },
+            { "!=", Condition::Token::KIND_NE },
+            { "<=", Condition::Token::KIND_LE },
+            { ">=", Condition::Token::KIND_GE },
+            { "<", Condition::Token::KIND_LT },
+            { ">", Condition::Token::KIND_GT }
+        };
+
+        for(size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); ++i)
+        {
+            if(accept(operators[i].op))
+            {
+                if(!parseOperand())
+                    return false;
+                appendOperator(operators[i].kind);
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    bool parseOperand()
+    {
+        skipSpaces();
+
+        if(pos >= source.size())
+        {
+            error = QObject::tr("unexpected end of the expression");
+            return false;
+        }
+
+        if(accept("("))
+        {
+            if(!parseOr())
+                return false;
+            if(!accept(")"))
+            {
+                error = QObject::tr("missing \")\"");
+                return false;
+            }
+            return true;
+        }
+
+        QChar c = source.at(pos);
+        Condition::Token token;
+        token.number = -1;
+
+        if(c == '"' || c == '\'')
+        {
+            int end = source.indexOf(c, pos + 1);
+            if(end < 0)
+            {
+                error = QObject::tr("unterminated string");
+                return false;
+            }
+
+            token.kind = Condition::Token::KIND_LITERAL;
+            token.literal = source.mid(pos + 1, end - pos - 1);
+            pos = end + 1;
+        }
+        else if(c.isDigit() || c == '-' || c == '.')
+        {
+            int start = pos++;
+            while(pos < source.size() &&
+                  (source.at(pos).isDigit() || source.at(pos) == '.'))
+                ++pos;
+
+            bool ok = false;
+            double number = source.mid(start, pos - start).toDouble(&ok);
+            if(!ok)
+            {
+                error = QObject::tr("invalid number \"") +
+                        source.mid(start, pos - start) + "\"";
+                return false;
+            }
+
+            token.kind = Condition::Token::KIND_LITERAL;
+            token.literal = number;
+        }
+        else if(c.isLetter() || c == '_')
+        {
+            int start = pos++;
+            while(pos < source.size() &&
+                  (source.at(pos).isLetterOrNumber() ||
+                   source.at(pos) == '_' || source.at(pos) == '-' ||
+                   source.at(pos) == '.' || source.at(pos) == '/'))
+                ++pos;
+
+            QString key(source.mid(start, pos - start));
+            QHash<QString, int>::const_iterator it = numbers.constFind(key);
+            if(it == numbers.constEnd())
+            {
+                error = QObject::tr("unknown item \"") + key + "\"";
+                return false;
+            }
+
+            token.kind = Condition::Token::KIND_ITEM;
+            token.number = it.value();
+            if(!condition->references.contains(token.number))
+                condition->references.append(token.number);
+        }
+        else
+        {
+            error = QObject::tr("unexpected \"") + source.mid(pos) + "\"";
+            return false;
+        }
+
+        condition->program.append(token);
+        return true;
+    }
+};
+
+/*
+ * whether a value counts as true: nothing is false, numbers are true unless
+ * they are 0, strings are true unless they are empty
+ */
+static bool isTrue(const QVariant& value)
+{
+    switch(value.type())
+    {
+    case QVariant::Invalid:
+        return false;
+    case QVariant::Bool:
+        return value.toBool();
+    case QVariant::String:
+        return !value.toString().isEmpty();
+    default:
+        return value.toDouble() != 0;
+    }
+}
+
+/*
+ * compare two values, the result is negative, 0 or positive like strcmp.
+ * Return false if they could not be compared because one of them is nothing.
+ */
+static bool compare(const QVariant& v1, const QVariant& v2, int* result)
+{
+    if(!v1.isValid() || !v2.isValid())
+        return false;
+
+    bool ok1 = false, ok2 = false;
+    double d1 = v1.toDouble(&ok1);
+    double d2 = v2.toDouble(&ok2);
+
+    if(ok1 && ok2)
+        *result = d1 < d2 ? -1 : (d1 > d2 ? 1 : 0);
+    else
+        *result = QString::compare(v1.toString(), v2.toString());
+
+    return true;
+}
+
+Condition::Condition()
+{
+}
+
+/*
+ * compile source, in which items are referred to by their keys. numbers maps
+ * the keys to the numbers of the items. An empty source is always true.
+ * Return false and set error if source is not a valid expression, in which
+ * case the condition is empty.
+ */
+bool Condition::compile(const QString& source,
+                        const QHash<QString, int>& numbers, QString* error)
+{
+    program.clear();
+    references.clear();
+
+    if(source.trimmed().isEmpty())
+        return true;
+
+    if(!ConditionParser(source, numbers, this).parse(error))
+    {
+        program.clear();
+        references.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool Condition::isEmpty() const
+{
+    return program.isEmpty();
+}
+
+/*
+ * the numbers of the items the condition refers to
+ */
+const QVector<int>& Condition::getReferences() const
+{
+    return references;
+}
+
+/*
+ * evaluate the condition with the values of the items, indexed by their
+ * numbers. Items which are not set in active evaluate to nothing.
+ */
+bool Condition::evaluate(const QVector<QVariant>& values,
+                         const QBitArray& active) const
+{
+    if(program.isEmpty())
+        return true;
+
+    QVarLengthArray<QVariant, 8> stack;
+
+    Q_FOREACH(const Token& token, program)
+    {
+        if(token.kind == Token::KIND_ITEM)
+        {
+            stack.append(active.testBit(token.number) ?
+                             values.value(token.number) : QVariant());
+            continue;
+        }
+        if(token.kind == Token::KIND_LITERAL)
+        {
+            stack.append(token.literal);
+            continue;
+        }
+        if(token.kind == Token::KIND_NOT)
+        {
+            stack.last() = !isTrue(stack.last());
+            continue;
+        }
+
+        // binary operators
+        QVariant v2(stack.last());
+        stack.removeLast();
+        QVariant v1(stack.last());
+        bool result = false;
+        int cmp = 0;
+
+        switch(token.kind)
+        {
+        case Token::KIND_AND:
+            result = isTrue(v1) && isTrue(v2);
+            break;
+        case Token::KIND_OR:
+            result = isTrue(v1) || isTrue(v2);
+            break;
+        case Token::KIND_EQ:
+            result = compare(v1, v2, &cmp) && cmp == 0;
+            break;
+        case Token::KIND_NE:
+            result = !compare(v1, v2, &cmp) || cmp != 0;
+            break;
+        case Token::KIND_LT:
+            result = compare(v1, v2, &cmp) && cmp < 0;
+            break;
+        case Token::KIND_LE:
+            result = compare(v1, v2, &cmp) && cmp <= 0;
+            break;
+        case Token::KIND_GT:
+            result = compare(v1, v2, &cmp) && cmp > 0;
+            break;
+        case Token::KIND_GE:
+            result = compare(v1, v2, &cmp) && cmp >= 0;
+            break;
+        default:
+            break;
+        }
+
+        stack.last() = result;
+    }
+
+    return isTrue(stack.last());
+}
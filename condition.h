@@ -0,0 +1,89 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONDITION_H
+#define CONDITION_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+// an "enabledif" or "visibleif" expression of an item, such as
+// "retype == 3 && !i", compiled once into reverse Polish notation over the
+// numbers of the items it refers to. The grammar is:
+//
+//   expr     := and ( "||" and )*
+//   and      := not ( "&&" not )*
+//   not      := "!" not | compare
+//   compare  := operand ( ( "==" | "!=" | "<" | "<=" | ">" | ">=" ) operand )?
+//   operand  := item key | number | "string" | 'string' | "(" expr ")"
+//
+// An item evaluates to its value: a bool for bool items, the selected index
+// for list items and the text for text and file items. An item which is not
+// active itself evaluates to nothing, which is false and not equal to
+// anything. Operands are compared as numbers if both are numbers, otherwise
+// as strings.
+class Condition
+{
+public:
+    Condition();
+
+    bool compile(const QString& source, const QHash<QString, int>& numbers,
+                 QString* error);
+
+    bool isEmpty() const;
+    const QVector<int>& getReferences() const;
+    bool evaluate(const QVector<QVariant>& values,
+                  const QBitArray& active) const;
+
+private:
+    struct Token
+    {
+        enum Kind
+        {
+            KIND_ITEM = 0,
+            KIND_LITERAL,
+            KIND_NOT,
+            KIND_AND,
+            KIND_OR,
+            KIND_EQ,
+            KIND_NE,
+            KIND_LT,
+            KIND_LE,
+            KIND_GT,
+            KIND_GE
+        };
+
+        enum Kind kind;
+        int number; // for KIND_ITEM
+        QVariant literal; // for KIND_LITERAL
+    };
+
+    QVector<Condition::Token> program;
+    QVector<int> references; // the numbers of the items referred to
+
+    friend class ConditionParser;
+};
+
+#endif // CONDITION_H
@@ -0,0 +1,152 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "confreloader.h"
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QRunnable>
+
+// the parse of the cla file performed on the thread pool
+class ConfReloadTask : public QRunnable
+{
+public:
+    ConfReloadTask(ConfReloader* reloader) :
+        reloader(reloader)
+    {
+    }
+
+    void run()
+    {
+        QString error;
+        Global* conf = Global::loadConfFile(reloader->confFile,
+                                            reloader->writeCache, &error);
+
+        {
+            QMutexLocker locker(&reloader->mutex);
+            delete reloader->conf;
+            reloader->conf = conf;
+            reloader->error = error;
+        }
+
+        QMetaObject::invokeMethod(reloader, "onReloadFinished",
+                                  Qt::QueuedConnection);
+    }
+
+private:
+    ConfReloader* reloader;
+};
+
+ConfReloader::ConfReloader(const QString& conf_file, bool write_cache,
+                           QObject* parent) :
+    QObject(parent),
+    confFile(conf_file),
+    writeCache(write_cache),
+    running(false),
+    pending(false),
+    retries(0),
+    conf(NULL)
+{
+    pool.setMaxThreadCount(1);
+
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(DEBOUNCE_DELAY);
+    connect(&debounceTimer, SIGNAL(timeout()), SLOT(startReload()));
+
+    watcher.addPath(confFile);
+    connect(&watcher, SIGNAL(fileChanged(QString)), SLOT(onFileChanged()));
+}
+
+ConfReloader::~ConfReloader()
+{
+    pool.waitForDone();
+    delete conf;
+}
+
+/*
+ * get the parsed cla file, which is then owned by the caller. Return NULL if
+ * there is none.
+ */
+Global* ConfReloader::takeConf()
+{
+    QMutexLocker locker(&mutex);
+    Global* result = conf;
+    conf = NULL;
+
+    return result;
+}
+
+void ConfReloader::onFileChanged()
+{
+    debounceTimer.start();
+}
+
+void ConfReloader::startReload()
+{
+    // editors which save by replacing the file make the watcher lose it. If
+    // the new file is not there yet, try again for a while.
+    if(!QFileInfo(confFile).exists())
+    {
+        if(++retries <= MAX_RETRIES)
+            debounceTimer.start();
+        return;
+    }
+    retries = 0;
+    if(!watcher.files().contains(confFile))
+        watcher.addPath(confFile);
+
+    if(running)
+    {
+        pending = true;
+        return;
+    }
+
+    running = true;
+    pool.start(new ConfReloadTask(this));
+}
+
+void ConfReloader::onReloadFinished()
+{
+    running = false;
+
+    QString error;
+    bool parsed;
+    {
+        QMutexLocker locker(&mutex);
+        error = this->error;
+        parsed = conf != NULL;
+    }
+
+    if(pending)
+    {
+        // the result is already outdated
+        pending = false;
+        startReload();
+        return;
+    }
+
+    if(parsed)
+        Q_EMIT reloaded();
+    else
+        Global::printText(stderr, QObject::tr("Unable to reload ") +
+                          confFile + ": " + error);
+}
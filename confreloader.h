@@ -0,0 +1,82 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONFRELOADER_H
+#define CONFRELOADER_H
+
+#include <QFileSystemWatcher>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include "global.h"
+
+// watch a cla file and parse it again on a worker thread when it is modified,
+// so that the main window could apply the changes while it is being edited
+class ConfReloader : public QObject
+{
+    Q_OBJECT
+
+    friend class ConfReloadTask;
+
+public:
+    ConfReloader(const QString& conf_file, bool write_cache,
+                 QObject* parent = 0);
+    ~ConfReloader();
+
+    Global* takeConf();
+
+Q_SIGNALS:
+    // emitted when a new version of the cla file has been parsed, which is
+    // available from takeConf()
+    void reloaded();
+
+private Q_SLOTS:
+    void onFileChanged();
+    void startReload();
+    void onReloadFinished();
+
+private:
+    // editors often write a file in several steps, a reload starts when the
+    // file has not been changed for this long, in milliseconds
+    static const int DEBOUNCE_DELAY = 200;
+    // how many times a missing file is looked for again after the delay
+    static const int MAX_RETRIES = 25;
+
+    QString confFile;
+    bool writeCache;
+    QFileSystemWatcher watcher;
+    QTimer debounceTimer;
+    // a pool of its own, so that the destructor only waits for the reload
+    QThreadPool pool;
+    bool running;
+    bool pending; // the file has been changed again while being parsed
+    int retries;
+
+    // the result of the task, protected by mutex
+    QMutex mutex;
+    Global* conf;
+    QString error;
+};
+
+#endif // CONFRELOADER_H
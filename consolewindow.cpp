@@ -0,0 +1,299 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "consolewindow.h"
+#include <QFile>
+#include <QFileDialog>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QMessageBox>
+#include <QScrollBar>
+#include <QTextCodec>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextStream>
+#include <QVBoxLayout>
+
+ConsoleWindow::ConsoleWindow(const QStringList& arguments,
+                             const QString& working_dir,
+                             const Spawner::Redirections& redirections,
+                             QWidget* parent) :
+    QWidget(parent),
+    arguments(arguments),
+    bufferStart(0),
+    droppedChars(0)
+{
+    setWindowTitle(arguments.join(" ") + "  --  " +
+                   QObject::tr("CmdLauncher"));
+    resize(800, 500);
+
+    ui.outputView = new QPlainTextEdit(this);
+    ui.outputView->setReadOnly(true);
+    ui.outputView->setUndoRedoEnabled(false);
+    ui.outputView->setMaximumBlockCount(SCROLLBACK_LINES);
+    ui.outputView->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    ui.searchLineEdit = new QLineEdit(this);
+    ui.searchLineEdit->setPlaceholderText(QObject::tr("Search"));
+    connect(ui.searchLineEdit, SIGNAL(returnPressed()), SLOT(findNext()));
+
+    QHBoxLayout* tmphbox = new QHBoxLayout();
+    tmphbox->addWidget(ui.searchLineEdit);
+    QPushButton* tmpbutton = new QPushButton(QObject::tr("Previous"), this);
+    connect(tmpbutton, SIGNAL(clicked()), SLOT(findPrevious()));
+    tmphbox->addWidget(tmpbutton);
+    tmpbutton = new QPushButton(QObject::tr("Next"), this);
+    connect(tmpbutton, SIGNAL(clicked()), SLOT(findNext()));
+    tmphbox->addWidget(tmpbutton);
+    tmphbox->addStretch();
+
+    ui.statusLabel = new QLabel(this);
+    tmphbox->addWidget(ui.statusLabel);
+    tmpbutton = new QPushButton(QObject::tr("Save..."), this);
+    connect(tmpbutton, SIGNAL(clicked()), SLOT(onClickedButtonSave()));
+    tmphbox->addWidget(tmpbutton);
+    ui.stopButton = new QPushButton(QObject::tr("Stop"), this);
+    connect(ui.stopButton, SIGNAL(clicked()), SLOT(onClickedButtonStop()));
+    tmphbox->addWidget(ui.stopButton);
+
+    QVBoxLayout* root_layout = new QVBoxLayout(this);
+    root_layout->addWidget(ui.outputView);
+    root_layout->addLayout(tmphbox);
+    setLayout(root_layout);
+
+    outputDecoder = QTextCodec::codecForLocale()->makeDecoder();
+    errorDecoder = QTextCodec::codecForLocale()->makeDecoder();
+
+    frameTimer = new QTimer(this);
+    frameTimer->setInterval(FRAME_INTERVAL);
+    connect(frameTimer, SIGNAL(timeout()), SLOT(renderFrame()));
+
+    process = new QProcess(this);
+    process->setWorkingDirectory(working_dir);
+    if(!redirections.stdinFile.isEmpty())
+        process->setStandardInputFile(redirections.stdinFile);
+    if(!redirections.stdoutFile.isEmpty())
+        process->setStandardOutputFile(redirections.stdoutFile);
+    if(!redirections.stderrFile.isEmpty())
+        process->setStandardErrorFile(redirections.stderrFile);
+    connect(process, SIGNAL(readyReadStandardOutput()),
+            SLOT(onReadyReadStandardOutput()));
+    connect(process, SIGNAL(readyReadStandardError()),
+            SLOT(onReadyReadStandardError()));
+    connect(process, SIGNAL(finished(int,QProcess::ExitStatus)),
+            SLOT(onProcessFinished(int,QProcess::ExitStatus)));
+    connect(process, SIGNAL(error(QProcess::ProcessError)),
+            SLOT(onProcessError(QProcess::ProcessError)));
+}
+
+ConsoleWindow::~ConsoleWindow()
+{
+    // don't leave the command running without any window showing it
+    if(process->state() != QProcess::NotRunning)
+    {
+        process->kill();
+        process->waitForFinished(1000);
+    }
+
+    delete outputDecoder;
+    delete errorDecoder;
+}
+
+/*
+ * start the command. Returns false if it could not be started.
+ */
+bool ConsoleWindow::start()
+{
+    if(arguments.isEmpty())
+        return false;
+
+    process->start(arguments.first(), arguments.mid(1));
+    if(!process->waitForStarted())
+        return false;
+
+    ui.statusLabel->setText(QObject::tr("Running"));
+    frameTimer->start();
+
+    return true;
+}
+
+void ConsoleWindow::onReadyReadStandardOutput()
+{
+    readOutput(QProcess::StandardOutput);
+}
+
+void ConsoleWindow::onReadyReadStandardError()
+{
+    readOutput(QProcess::StandardError);
+}
+
+/*
+ * decode the output of a channel and move it to the buffer, dropping the
+ * oldest output if the buffer is full
+ */
+void ConsoleWindow::readOutput(QProcess::ProcessChannel channel)
+{
+    QTextDecoder* decoder = channel == QProcess::StandardError ?
+        errorDecoder : outputDecoder;
+
+    process->setReadChannel(channel);
+    buffer += decoder->toUnicode(process->readAll());
+
+    int pending = buffer.size() - bufferStart;
+    if(pending > BUFFER_SIZE)
+    {
+        droppedChars += pending - BUFFER_SIZE;
+        bufferStart += pending - BUFFER_SIZE;
+    }
+
+    // the consumed output is only removed once it is large, so that the
+    // buffer is not moved on every read
+    if(bufferStart > BUFFER_SIZE / 2)
+    {
+        buffer.remove(0, bufferStart);
+        bufferStart = 0;
+    }
+}
+
+/*
+ * render at most FRAME_SIZE characters of the buffer
+ */
+void ConsoleWindow::renderFrame()
+{
+    if(droppedChars > 0)
+    {
+        ui.outputView->appendPlainText(
+                    QObject::tr("[%1 characters of output skipped]")
+                    .arg(droppedChars));
+        droppedChars = 0;
+    }
+
+    if(bufferStart >= buffer.size())
+    {
+        buffer.clear();
+        bufferStart = 0;
+        if(process->state() == QProcess::NotRunning)
+            frameTimer->stop();
+        return;
+    }
+
+    QString chunk(buffer.mid(bufferStart, FRAME_SIZE));
+    // a surrogate pair is not split between two frames
+    if(chunk.size() > 1 && chunk.at(chunk.size() - 1).isHighSurrogate() &&
+            bufferStart + chunk.size() < buffer.size())
+        chunk.chop(1);
+    bufferStart += chunk.size();
+
+    // keep the view at the bottom only if the user has not scrolled up
+    QScrollBar* bar = ui.outputView->verticalScrollBar();
+    bool at_bottom = bar->value() == bar->maximum();
+
+    QTextCursor cursor(ui.outputView->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(chunk);
+
+    if(at_bottom)
+        bar->setValue(bar->maximum());
+}
+
+void ConsoleWindow::onProcessFinished(int exit_code,
+                                      QProcess::ExitStatus exit_status)
+{
+    // the remaining output is rendered by the following frames
+    readOutput(QProcess::StandardOutput);
+    readOutput(QProcess::StandardError);
+    frameTimer->start();
+
+    if(exit_status == QProcess::CrashExit)
+        ui.statusLabel->setText(QObject::tr("Crashed"));
+    else
+        ui.statusLabel->setText(QObject::tr("Exited with code %1")
+                                .arg(exit_code));
+    ui.stopButton->setEnabled(false);
+}
+
+void ConsoleWindow::onProcessError(QProcess::ProcessError error)
+{
+    if(error == QProcess::FailedToStart)
+    {
+        ui.statusLabel->setText(QObject::tr("Failed to start"));
+        ui.stopButton->setEnabled(false);
+    }
+}
+
+void ConsoleWindow::onClickedButtonStop()
+{
+    process->terminate();
+}
+
+/*
+ * save the output kept in the view
+ */
+void ConsoleWindow::onClickedButtonSave()
+{
+    QString file(QFileDialog::getSaveFileName(
+                     this, QObject::tr("Save the output")));
+
+    if(file.isEmpty())
+        return;
+
+    QFile f(file);
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        QMessageBox::warning(this, QObject::tr("CmdLauncher"),
+                             QObject::tr("Unable to write ") + file);
+        return;
+    }
+
+    QTextStream out(&f);
+    out << ui.outputView->toPlainText();
+}
+
+void ConsoleWindow::findNext()
+{
+    const QString text(ui.searchLineEdit->text());
+
+    if(text.isEmpty())
+        return;
+
+    // wrap around to the beginning
+    if(!ui.outputView->find(text))
+    {
+        ui.outputView->moveCursor(QTextCursor::Start);
+        ui.outputView->find(text);
+    }
+}
+
+void ConsoleWindow::findPrevious()
+{
+    const QString text(ui.searchLineEdit->text());
+
+    if(text.isEmpty())
+        return;
+
+    // wrap around to the end
+    if(!ui.outputView->find(text, QTextDocument::FindBackward))
+    {
+        ui.outputView->moveCursor(QTextCursor::End);
+        ui.outputView->find(text, QTextDocument::FindBackward);
+    }
+}
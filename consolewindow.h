@@ -0,0 +1,98 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONSOLEWINDOW_H
+#define CONSOLEWINDOW_H
+
+#include <QLabel>
+#include <QLineEdit>
+#include <QPlainTextEdit>
+#include <QProcess>
+#include <QPushButton>
+#include <QString>
+#include <QStringList>
+#include <QTextDecoder>
+#include <QTimer>
+#include <QWidget>
+#include "spawner.h"
+
+// the "internal console" terminal: runs the command with QProcess and shows
+// its output. The output is collected in a bounded buffer and rendered at
+// most once per frame, so that a command writing a lot of output does not
+// freeze the window. When the buffer is full, the oldest output which has
+// not been rendered yet is dropped.
+class ConsoleWindow : public QWidget
+{
+    Q_OBJECT
+public:
+    // maximum size of the output waiting to be rendered, in characters
+    static const int BUFFER_SIZE = 4 * 1024 * 1024;
+    // maximum output rendered in one frame, in characters
+    static const int FRAME_SIZE = 256 * 1024;
+    // interval between two frames, in milliseconds
+    static const int FRAME_INTERVAL = 40;
+    // number of lines kept in the view
+    static const int SCROLLBACK_LINES = 20000;
+
+    ConsoleWindow(const QStringList& arguments, const QString& working_dir,
+                  const Spawner::Redirections& redirections,
+                  QWidget* parent = NULL);
+    ~ConsoleWindow();
+
+    bool start();
+
+private:
+    struct UI
+    {
+        QPlainTextEdit* outputView;
+        QLineEdit*      searchLineEdit;
+        QPushButton*    stopButton;
+        QLabel*         statusLabel;
+    } ui;
+
+    QProcess* process;
+    QStringList arguments;
+    // decoded output not rendered yet, from bufferStart
+    QString buffer;
+    int bufferStart;
+    qint64 droppedChars;
+    // one decoder per channel, so that a character split between two reads
+    // of a channel is not mixed with the output of the other one
+    QTextDecoder* outputDecoder;
+    QTextDecoder* errorDecoder;
+    QTimer* frameTimer;
+
+    void readOutput(QProcess::ProcessChannel channel);
+
+private Q_SLOTS:
+    void onReadyReadStandardOutput();
+    void onReadyReadStandardError();
+    void onProcessFinished(int exit_code, QProcess::ExitStatus exit_status);
+    void onProcessError(QProcess::ProcessError error);
+    void renderFrame();
+    void onClickedButtonStop();
+    void onClickedButtonSave();
+    void findNext();
+    void findPrevious();
+};
+
+#endif // CONSOLEWINDOW_H
@@ -0,0 +1,133 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dirlister.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QMetaObject>
+#include <QRunnable>
+#include <QThreadPool>
+
+static DirLister* instance = NULL;
+
+// the listing performed on the thread pool
+class DirListTask : public QRunnable
+{
+public:
+    DirListTask(DirLister* lister, const QString& dir) :
+        lister(lister), dir(dir)
+    {
+    }
+
+    void run()
+    {
+        QStringList entries;
+        QDirIterator it(dir, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
+
+        while(it.hasNext() && entries.size() < DirLister::MAX_LISTING)
+        {
+            it.next();
+            if(it.fileInfo().isDir())
+                entries.append(it.fileName() + '/');
+            else
+                entries.append(it.fileName());
+        }
+
+        entries.sort();
+
+        QMetaObject::invokeMethod(lister, "store", Qt::QueuedConnection,
+                                  Q_ARG(QString, dir),
+                                  Q_ARG(QStringList, entries));
+    }
+
+private:
+    DirLister* lister;
+    QString dir;
+};
+
+DirLister::DirLister() :
+    listings(MAX_CACHED_ENTRIES)
+{
+    clock.start();
+}
+
+/*
+ * the instance lives until the end of the program, since tasks may still be
+ * running on the thread pool when it is no longer used
+ */
+DirLister* DirLister::getInstance()
+{
+    if(!instance)
+        instance = new DirLister;
+
+    return instance;
+}
+
+/*
+ * get the listing of dir. Returns false if it is unknown or expired.
+ */
+bool DirLister::lookup(const QString& dir, QStringList* entries)
+{
+    Listing* listing = listings.object(dir);
+
+    if(!listing)
+        return false;
+
+    if(clock.elapsed() - listing->time > TTL)
+    {
+        listings.remove(dir);
+        return false;
+    }
+
+    if(entries)
+        *entries = listing->entries;
+
+    return true;
+}
+
+/*
+ * list dir on the thread pool, ready() is emitted when it is done. Nothing
+ * is done if the directory is already being listed.
+ */
+void DirLister::request(const QString& dir)
+{
+    if(pending.contains(dir))
+        return;
+
+    pending.insert(dir);
+    QThreadPool::globalInstance()->start(new DirListTask(this, dir));
+}
+
+void DirLister::store(const QString& dir, const QStringList& entries)
+{
+    pending.remove(dir);
+
+    Listing* listing = new Listing;
+    listing->entries = entries;
+    listing->time = clock.elapsed();
+
+    // the cost is the number of entries, so that a few huge directories
+    // could not take all the memory
+    listings.insert(dir, listing, entries.size() + 1);
+
+    Q_EMIT ready(dir);
+}
@@ -0,0 +1,73 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DIRLISTER_H
+#define DIRLISTER_H
+
+#include <QCache>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// list directories on a worker thread, one level at a time, and keep the
+// listings in a LRU cache. Used for the path completion of FileSelector.
+class DirLister : public QObject
+{
+    Q_OBJECT
+public:
+    // how long a listing stays valid, in milliseconds
+    static const qint64 TTL = 30000;
+    // the total number of entries of the cached listings
+    static const int MAX_CACHED_ENTRIES = 400000;
+    // longer listings are truncated
+    static const int MAX_LISTING = 200000;
+
+    static DirLister* getInstance();
+
+    bool lookup(const QString& dir, QStringList* entries);
+    void request(const QString& dir);
+
+Q_SIGNALS:
+    // emitted in the GUI thread when the listing of a directory is known
+    void ready(const QString& dir);
+
+private Q_SLOTS:
+    void store(const QString& dir, const QStringList& entries);
+
+private:
+    DirLister();
+
+    // entry names, the names of directories end with a '/'
+    struct Listing
+    {
+        QStringList entries;
+        qint64 time;
+    };
+
+    QCache<QString, Listing> listings;
+    QSet<QString> pending;
+    QElapsedTimer clock;
+};
+
+#endif // DIRLISTER_H
@@ -0,0 +1,45 @@
+#!/bin/sh
+#
+# Generate a cla file with many items, to try the main window with large cla
+# files by hand (see the --render option). The scroll latency and the memory
+# of the window are measured by cmdlauncher_bench, see "make bench".
+#
+# Usage: large.sh [number of items] > large.cla
+#
+# By default 10000 items spread on 10 tabs are generated.
+
+awk -v n="${1:-10000}" 'BEGIN {
+    types[0] = "bool"; types[1] = "text"; types[2] = "list"; types[3] = "file"
+
+    print "general:"
+    print "    cmd: echo"
+    print "    title: " n " items"
+    tabs = "tab0"
+    for (t = 1; t < 10; ++t)
+        tabs = tabs ",tab" t
+    print "    tabs: " tabs
+    print ""
+    print "items:"
+
+    for (i = 0; i < n; ++i) {
+        type = types[i % 4]
+        print "    item" i ":"
+        print "        title: item " i " (" type ")"
+        print "        type: " type
+        print "        tab: tab" (i % 10)
+        print "        order: " i
+        if (type == "bool") {
+            print "        default: " (i % 2)
+            print "        value/yes: --yes" i
+            print "        value/no: --no" i
+        } else if (type == "list") {
+            print "        list: zero,one,two,three"
+            print "        default: " (i % 4)
+            for (v = 0; v < 4; ++v)
+                print "        value/" v ": --list" i "=" v
+        } else {
+            print "        default: value" i
+            print "        value/nonempty: --" type i "=%a"
+        }
+    }
+}'
@@ -0,0 +1,125 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fileinfocache.h"
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QRunnable>
+#include <QThreadPool>
+
+static FileInfoCache* instance = NULL;
+
+// the stat performed on the thread pool
+class FileInfoTask : public QRunnable
+{
+public:
+    FileInfoTask(FileInfoCache* cache, const QString& path) :
+        cache(cache), path(path)
+    {
+    }
+
+    void run()
+    {
+        QFileInfo fi(path);
+
+        QMetaObject::invokeMethod(cache, "store", Qt::QueuedConnection,
+                                  Q_ARG(QString, path),
+                                  Q_ARG(bool, fi.exists()),
+                                  Q_ARG(bool, fi.isDir()),
+                                  Q_ARG(bool, fi.isFile()));
+    }
+
+private:
+    FileInfoCache* cache;
+    QString path;
+};
+
+FileInfoCache::FileInfoCache()
+{
+    clock.start();
+}
+
+/*
+ * the instance lives until the end of the program, since tasks may still be
+ * running on the thread pool when it is no longer used
+ */
+FileInfoCache* FileInfoCache::getInstance()
+{
+    if(!instance)
+        instance = new FileInfoCache;
+
+    return instance;
+}
+
+/*
+ * get the result of a previous request. Returns false if the result is
+ * unknown or expired.
+ */
+bool FileInfoCache::lookup(const QString& path, FileInfoCache::Info* info)
+{
+    QHash<QString, Entry>::const_iterator it = entries.constFind(path);
+
+    if(it == entries.constEnd() || clock.elapsed() - it->time > TTL)
+        return false;
+
+    if(info)
+        *info = it->info;
+
+    return true;
+}
+
+/*
+ * stat path on the thread pool, ready() is emitted when it is done. Nothing
+ * is done if the path is already being checked.
+ */
+void FileInfoCache::request(const QString& path)
+{
+    if(pending.contains(path))
+        return;
+
+    pending.insert(path);
+    QThreadPool::globalInstance()->start(new FileInfoTask(this, path));
+}
+
+void FileInfoCache::store(const QString& path, bool exists, bool is_dir,
+                          bool is_file)
+{
+    pending.remove(path);
+
+    const qint64 now = clock.elapsed();
+
+    if(entries.size() >= MAX_ENTRIES)
+    {
+        QMutableHashIterator<QString, Entry> it(entries);
+        while(it.hasNext())
+            if(now - it.next().value().time > TTL)
+                it.remove();
+    }
+
+    Entry& entry = entries[path];
+    entry.info.exists = exists;
+    entry.info.isDir = is_dir;
+    entry.info.isFile = is_file;
+    entry.time = now;
+
+    Q_EMIT ready(path);
+}
@@ -0,0 +1,77 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FILEINFOCACHE_H
+#define FILEINFOCACHE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+// stat files on a worker thread, so that slow file systems (NFS, FUSE...)
+// never block the GUI thread, and remember the results for a short time
+class FileInfoCache : public QObject
+{
+    Q_OBJECT
+public:
+    // how long a result stays valid, in milliseconds
+    static const qint64 TTL = 5000;
+    // expired results are pruned when there are more than this many
+    static const int MAX_ENTRIES = 256;
+
+    struct Info
+    {
+        bool exists;
+        bool isDir;
+        bool isFile;
+    };
+
+    static FileInfoCache* getInstance();
+
+    bool lookup(const QString& path, FileInfoCache::Info* info);
+    void request(const QString& path);
+
+Q_SIGNALS:
+    // emitted in the GUI thread when the result of a request is known
+    void ready(const QString& path);
+
+private Q_SLOTS:
+    void store(const QString& path, bool exists, bool is_dir,
+               bool is_file);
+
+private:
+    FileInfoCache();
+
+    struct Entry
+    {
+        FileInfoCache::Info info;
+        qint64 time;
+    };
+
+    QHash<QString, Entry> entries;
+    QSet<QString> pending;
+    QElapsedTimer clock;
+};
+
+#endif // FILEINFOCACHE_H
@@ -21,11 +21,12 @@
  */
 
 #include "fileselector.h"
+#include "fileinfocache.h"
+#include "pathcompleter.h"
 #include <QCoreApplication>
 #include <QDir>
 #include <QEvent>
 #include <QFileDialog>
-#include <QFileInfo>
 #include <QHBoxLayout>
 #include <QMenu>
 #include <QMessageBox>
@@ -35,7 +36,8 @@
 #include <QUrl>
 
 FileSelector::FileSelector(QWidget *parent) :
-    QWidget(parent)
+    QWidget(parent),
+    completer(NULL)
 {
     lineEdit = new QLineEdit(this);
     pushButton = new QPushButton("...", this);
@@ -51,6 +53,10 @@ FileSelector::FileSelector(QWidget *parent) :
     setLayout(tmplayout);
 
     lineEdit->installEventFilter(this);
+    connect(lineEdit, SIGNAL(textChanged(QString)),
+            SIGNAL(textChanged(QString)));
+    connect(lineEdit, SIGNAL(textEdited(QString)),
+            SLOT(onTextEdited(QString)));
 
     // default file mode is "file"
     setFileMode(FILEMODE_FILE);
@@ -59,6 +65,9 @@ FileSelector::FileSelector(QWidget *parent) :
     // lineedit
     setAcceptDrops(true);
     lineEdit->setAcceptDrops(false);
+
+    connect(FileInfoCache::getInstance(), SIGNAL(ready(QString)),
+            SLOT(onFileInfoReady(QString)));
 }
 
 bool FileSelector::eventFilter(QObject * watched, QEvent * event)
@@ -95,6 +104,24 @@ bool FileSelector::eventFilter(QObject * watched, QEvent * event)
     return QWidget::eventFilter(watched, event);
 }
 
+/*
+ * complete the typed path. The completer is created on the first edit, so
+ * that the many selectors of a large cla file stay cheap to create.
+ */
+void FileSelector::onTextEdited(const QString& text)
+{
+    if(!completer)
+    {
+        completer = new PathCompleter(lineEdit);
+        completer->setDir(dir);
+        completer->setFilter(filter);
+        completer->setDirsOnly(fileMode == FILEMODE_DIR);
+        lineEdit->setCompleter(completer);
+    }
+
+    completer->update(text);
+}
+
 QLineEdit* FileSelector::getLineEdit()
 {
     return lineEdit;
@@ -169,11 +196,15 @@ void FileSelector::openDirBrowser()
 void FileSelector::setDir(const QString& dir)
 {
     this->dir = dir;
+    if(completer)
+        completer->setDir(dir);
 }
 
 void FileSelector::setFilter(const QString& filter)
 {
     this->filter = filter;
+    if(completer)
+        completer->setFilter(filter);
 }
 
 void FileSelector::setFileMustExist(bool existance)
@@ -184,6 +215,8 @@ void FileSelector::setFileMustExist(bool existance)
 void FileSelector::setFileMode(enum FileMode fm)
 {
     this->fileMode = fm;
+    if(completer)
+        completer->setDirsOnly(fm == FILEMODE_DIR);
 
     // disconnect current connections before set connections
     this->pushButton->disconnect(this);
@@ -207,10 +240,38 @@ enum FileSelector::FileMode FileSelector::getFileMode()
     return fileMode;
 }
 
+/*
+ * whether the type (file or directory) of path matches the file mode. If
+ * the file has not been checked yet, known is set to false, a check is
+ * started and the path is accepted for now.
+ */
+bool FileSelector::isAcceptedPath(const QString& path, bool* known)
+{
+    *known = true;
+
+    if(fileMode == FILEMODE_BOTH)
+        return true;
+
+    FileInfoCache* cache = FileInfoCache::getInstance();
+    FileInfoCache::Info info;
+
+    if(!cache->lookup(path, &info))
+    {
+        *known = false;
+        cache->request(path);
+        return true;
+    }
+
+    return (fileMode == FILEMODE_DIR && info.isDir) ||
+        (fileMode == FILEMODE_FILE && info.isFile);
+}
+
 void FileSelector::dragEnterEvent(QDragEnterEvent* event)
 {
     // allow any file to be dropped here, if there is only one file dropped
-    // here, and the type(file or directory) is matched
+    // here, and the type(file or directory) is matched. The type is checked
+    // on a worker thread; until it is known, the drag is accepted
+    // provisionally.
     if(!event->mimeData()->hasUrls())
         return;
 
@@ -219,12 +280,28 @@ void FileSelector::dragEnterEvent(QDragEnterEvent* event)
     if(urls.count() != 1)
         return;
 
-    QFileInfo fi(urls[0].toLocalFile());
+    bool known;
+    dragPath = urls[0].toLocalFile();
+
+    if(isAcceptedPath(dragPath, &known))
+        event->acceptProposedAction();
+}
+
+void FileSelector::dragMoveEvent(QDragMoveEvent* event)
+{
+    // refuse the drag once the check tells the type does not match
+    bool known;
 
-    if((fileMode == FILEMODE_DIR && fi.isDir()) ||
-            (fileMode == FILEMODE_FILE && fi.isFile()) ||
-            fileMode == FILEMODE_BOTH)
+    if(dragPath.isEmpty() || isAcceptedPath(dragPath, &known))
         event->acceptProposedAction();
+    else
+        event->ignore();
+}
+
+void FileSelector::dragLeaveEvent(QDragLeaveEvent* event)
+{
+    dragPath.clear();
+    QWidget::dragLeaveEvent(event);
 }
 
 void FileSelector::dropEvent(QDropEvent *event)
@@ -234,15 +311,55 @@ void FileSelector::dropEvent(QDropEvent *event)
 
     const QList<QUrl> urls = event->mimeData()->urls();
 
+    dragPath.clear();
+
     if(urls.count() != 1)
         return;
 
     QString local_path(urls[0].toLocalFile());
+    FileInfoCache* cache = FileInfoCache::getInstance();
+
+    event->acceptProposedAction();
+
+    // the type of the file is needed unless any type is accepted, and the
+    // existence of the file is needed for the overwrite warning. Wait for
+    // the check if its result is not known yet.
+    if((fileMode != FILEMODE_BOTH || !fileMustExist) &&
+            !cache->lookup(local_path, NULL))
+    {
+        dropPath = local_path;
+        cache->request(local_path);
+        return;
+    }
+
+    finishDrop(local_path);
+}
+
+void FileSelector::onFileInfoReady(const QString& path)
+{
+    if(dropPath.isEmpty() || path != dropPath)
+        return;
+
+    dropPath.clear();
+    finishDrop(path);
+}
+
+/*
+ * use the dropped path once its file check is done
+ */
+void FileSelector::finishDrop(const QString& path)
+{
+    FileInfoCache::Info info;
+    bool known;
+
+    if(!isAcceptedPath(path, &known) || !known)
+        return;
 
     // if fileMustExist is set to 0 and an existing file is dropped here,
     // give a warning dialog
     if(!fileMustExist &&
-            QFileInfo(local_path).exists() &&
+            FileInfoCache::getInstance()->lookup(path, &info) &&
+            info.exists &&
             QMessageBox::warning(this,
                 QObject::tr("CmdLauncher"),
                 QObject::tr("The file already exists, and it may be "
@@ -251,5 +368,5 @@ void FileSelector::dropEvent(QDropEvent *event)
                 QMessageBox::Yes, QMessageBox::No) != QMessageBox::Yes)
         return;
 
-    lineEdit->setText(QDir::toNativeSeparators(local_path));
+    lineEdit->setText(QDir::toNativeSeparators(path));
 }
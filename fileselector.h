@@ -24,11 +24,15 @@
 #define FILESELECTOR_H
 
 #include <QDragEnterEvent>
+#include <QDragLeaveEvent>
+#include <QDragMoveEvent>
 #include <QDropEvent>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QWidget>
 
+class PathCompleter;
+
 // this class provide a widget which contains a lineedit in the left and a
 // push button in the right, used for selecting a file and display them
 class FileSelector : public QWidget
@@ -40,6 +44,8 @@ public:
 private:
     QLineEdit*   lineEdit;
     QPushButton* pushButton;
+    // created when the text is first edited
+    PathCompleter* completer;
 
     // used for file dialog
     QString dir;
@@ -56,6 +62,14 @@ public:
 private:
     enum FileMode fileMode;
 
+    // the file checks of drag and drop run on a worker thread: the path
+    // being dragged over, and the dropped path waiting for its result
+    QString dragPath;
+    QString dropPath;
+
+    bool isAcceptedPath(const QString& path, bool* known);
+    void finishDrop(const QString& path);
+
 public:
     QLineEdit* getLineEdit();
     QPushButton* getPushButton();
@@ -66,11 +80,19 @@ public:
     void setFileMode(enum FileMode fm);
     enum FileMode getFileMode();
 
+Q_SIGNALS:
+    // emitted when the text in the lineedit is changed
+    void textChanged(const QString& text);
+
 protected:
     void dragEnterEvent(QDragEnterEvent *event);
+    void dragMoveEvent(QDragMoveEvent *event);
+    void dragLeaveEvent(QDragLeaveEvent *event);
     void dropEvent(QDropEvent *event);
 
 private Q_SLOTS:
+    void onFileInfoReady(const QString& path);
+    void onTextEdited(const QString& text);
     void openFileBrowser();
     void openDirBrowser();
     void popupFileModeMenu();
@@ -21,35 +21,622 @@
  */
 
 #include "global.h"
+#include "clacache.h"
+#include "profiler.h"
 #include <QApplication>
 #include <QDesktopWidget>
+#include <QDir>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QRegExp>
+#include <QStandardPaths>
 #include <QStringList>
 #include <QTextStream>
 #include <QtAlgorithms>
 #include <cstdlib>
 #include <yaml-cpp/yaml.h>
 
-Global::Global()
+/*
+ * load the cla file given in arguments. loaded are instances created before
+ * by a daemon, indexed by the absolute path of their cla file: if the cla
+ * file has not been modified since one of them was created, the items are
+ * copied from it instead of loading the file again. The new instance is
+ * resident when loaded is given.
+ */
+Global::Global(const QStringList& arguments,
+               const QHash<QString, Global*>* loaded) :
+    confSize(-1),
+    workingDir(QDir::currentPath()),
+    itemIndexBuilt(false),
+    renderMode(RENDERMODE_AUTO),
+    headlessMode(HEADLESSMODE_NONE),
+    maxJobs(0),
+    useCache(true),
+    rebuildCache(false),
+    resident(loaded != NULL),
+    failed(false),
+    exitCode(0)
 {
-    QStringList arguments = qApp->arguments();
-
-    // set default startup geometry
+    // set default startup geometry. There is no desktop when no window is
+    // going to be shown.
     startupGeometry.setWidth(800);
     startupGeometry.setHeight(600);
-    startupGeometry.setX((QApplication::desktop()->width() -
-                          startupGeometry.width())/2);
-    startupGeometry.setY((QApplication::desktop()->height() -
-                          startupGeometry.height())/2);
+    if(hasGui())
+    {
+        startupGeometry.setX((QApplication::desktop()->width() -
+                              startupGeometry.width())/2);
+        startupGeometry.setY((QApplication::desktop()->height() -
+                              startupGeometry.height())/2);
+    }
 
     // parse the arguments first
+    bool geometry_set = parseArguments(arguments);
+    if(failed)
+        return;
+
+    // if no cla file is specified, ask the user to choose one. If the user
+    // cancels, exit
+    if(confFile.isEmpty() && !hasGui())
+    {
+        Global::printText(stderr, QObject::tr("You must specify a cla file"));
+        fail(3);
+        return;
+    }
+    else if(confFile.isEmpty())
+    {
+        QString message(QObject::tr("You must specify a cla file"));
+
+        QMessageBox::information(NULL, QObject::tr("CmdLauncher"), message);
+
+        confFile = QFileDialog::getOpenFileName(NULL, message);
+
+        if(confFile.isEmpty())
+        {
+            fail(3);
+            return;
+        }
+    }
+    // if the cla file is not readable, then we give an error message and exit
+    QFileInfo fi_ini(confFile);
+    if(!fi_ini.isReadable())
+    {
+        QString message(QObject::tr("Unable to load file") + " \"" +
+                confFile + "\". " + QObject::tr("Now Exit."));
+        printText(stderr, message
+#ifdef Q_OS_WIN
+                , MESSAGEBOXTYPE_CRITICAL
+#endif
+                );
+        fail(4);
+        return;
+    }
+    confFile = fi_ini.absoluteFilePath();
+    confModified = fi_ini.lastModified();
+    confSize = fi_ini.size();
+
+    // a daemon already has the items if the cla file is unchanged
+    const Global* other = loaded ? loaded->value(confFile, NULL) : NULL;
+    if(other && !rebuildCache && other->confModified == confModified &&
+            other->confSize == confSize)
+        copyConfFrom(other);
+    else
+    {
+        // load the cla file from the cache if possible, otherwise parse it
+        // and refresh the cache
+        bool cached = false;
+        if(useCache && !rebuildCache)
+        {
+            ProfileScope profile("read cache");
+            cached = ClaCache::read(confFile, this);
+        }
+        if(!cached)
+        {
+            QString error;
+            if(!parseConfFile(&error))
+            {
+                Global::printText(stderr, error);
+                if(hasGui())
+                    QMessageBox(QMessageBox::Critical,
+                                QObject::tr("CmdLauncher"), error).exec();
+                fail(5);
+                return;
+            }
+
+            ProfileScope profile("write cache");
+            if(useCache && !ClaCache::write(confFile, this))
+                Global::printText(stderr, QObject::tr(
+                            "[WARNING] Unable to write the cache of ") +
+                        confFile);
+        }
+
+        prepareItems();
+    }
+
+    Q_FOREACH(Global::Item* item, items)
+        itemsByKey.insert(item->key, item);
+    compileConditions();
+
+    if(!claGeometry.isEmpty() && !geometry_set)
+        this->startupGeometry = convertGeometryStringToRect(claGeometry);
+}
+
+/*
+ * an instance holding only what is loaded from a cla file, see
+ * loadConfFile()
+ */
+Global::Global() :
+    confSize(-1),
+    itemIndexBuilt(false),
+    renderMode(RENDERMODE_AUTO),
+    headlessMode(HEADLESSMODE_NONE),
+    maxJobs(0),
+    useCache(true),
+    rebuildCache(false),
+    resident(true),
+    failed(false),
+    exitCode(0)
+{
+}
+
+Global::~Global()
+{
+    qDeleteAll(items);
+    qDeleteAll(terminals);
+}
+
+/*
+ * copy what is loaded from the cla file from another instance. The items
+ * are already sorted and compiled.
+ */
+void Global::copyConfFrom(const Global* other)
+{
+    ProfileScope profile("copy loaded items");
+
+    windowTitle = other->windowTitle;
+    command = other->command;
+    tabs = other->tabs;
+    about = other->about;
+    claGeometry = other->claGeometry;
+    redirections = other->redirections;
+    claTerminals = other->claTerminals;
+
+    items.reserve(other->items.size());
+    Q_FOREACH(const Global::Item* item, other->items)
+        items.append(new Global::Item(*item));
+}
+
+/*
+ * sort the items according to "order", then give them a number and compile
+ * their templates
+ */
+void Global::prepareItems()
+{
+    {
+        ProfileScope profile("sort items by order");
+        qSort(items.begin(), items.end(), Global::lessThanItemsOrder);
+    }
+
+    int item_count = items.count();
+    for(int i = 0; i < item_count; ++i)
+    {
+        items.at(i)->number = i;
+        items.at(i)->compileTemplates();
+        items.at(i)->compileValidation();
+    }
+}
+
+/*
+ * compile the conditions of the items and sort the items with conditions
+ * topologically, so that an item is evaluated after the items its conditions
+ * refer to. The conditions of items which are part of a cycle are dropped.
+ */
+void Global::compileConditions()
+{
+    ProfileScope profile("compile conditions");
+
+    int item_count = items.count();
+    QHash<QString, int> numbers;
+    bool has_conditions = false;
+
+    Q_FOREACH(const Global::Item* item, items)
+    {
+        numbers.insert(item->key, item->number);
+        if(!item->enabledIf.isEmpty() || !item->visibleIf.isEmpty())
+            has_conditions = true;
+    }
+
+    conditionDependents.clear();
+    conditionOrder.clear();
+    conditionRanks.clear();
+    conditionDependents.resize(item_count);
+    conditionRanks.fill(-1, item_count);
+
+    if(!has_conditions)
+        return;
+
+    QVector<int> pending_refs(item_count, 0);
+    Q_FOREACH(Global::Item* item, items)
+    {
+        QString error;
+        if(!item->enabledCondition.compile(item->enabledIf, numbers, &error))
+            Global::printText(stderr, QObject::tr("[WARNING] Item \"") +
+                              item->key + QObject::tr("\": enabledif: ") +
+                              error);
+        if(!item->visibleCondition.compile(item->visibleIf, numbers, &error))
+            Global::printText(stderr, QObject::tr("[WARNING] Item \"") +
+                              item->key + QObject::tr("\": visibleif: ") +
+                              error);
+
+        QVector<int> refs(item->enabledCondition.getReferences());
+        Q_FOREACH(int ref, item->visibleCondition.getReferences())
+            if(!refs.contains(ref))
+                refs.append(ref);
+
+        Q_FOREACH(int ref, refs)
+            conditionDependents[ref].append(item->number);
+        pending_refs[item->number] = refs.count();
+    }
+
+    // Kahn's algorithm, starting from the items which don't refer to any
+    QVector<int> ready;
+    QVector<int> order;
+    for(int i = 0; i < item_count; ++i)
+        if(pending_refs.at(i) == 0)
+            ready.append(i);
+    while(!ready.isEmpty())
+    {
+        int number = ready.last();
+        ready.removeLast();
+        order.append(number);
+
+        Q_FOREACH(int dependent, conditionDependents.at(number))
+            if(--pending_refs[dependent] == 0)
+                ready.append(dependent);
+    }
+
+    for(int i = 0; i < item_count; ++i)
+    {
+        if(pending_refs.at(i) == 0)
+            continue;
+
+        Global::Item* item = items.at(i);
+        Global::printText(stderr, QObject::tr("[WARNING] Item \"") +
+                          item->key + QObject::tr(
+                              "\": the conditions are part of or depend on a "
+                              "cycle, they are ignored"));
+        item->enabledCondition = Condition();
+        item->visibleCondition = Condition();
+        order.append(i);
+    }
+
+    // the dependents of the dropped conditions are not needed any more
+    for(int i = 0; i < item_count; ++i)
+    {
+        QVector<int>& dependents = conditionDependents[i];
+        for(int j = dependents.count() - 1; j >= 0; --j)
+        {
+            const Global::Item* dependent = items.at(dependents.at(j));
+            if(dependent->enabledCondition.isEmpty() &&
+                    dependent->visibleCondition.isEmpty())
+                dependents.remove(j);
+        }
+    }
+
+    Q_FOREACH(int number, order)
+    {
+        const Global::Item* item = items.at(number);
+        if(item->enabledCondition.isEmpty() &&
+                item->visibleCondition.isEmpty())
+            continue;
+
+        conditionRanks[number] = conditionOrder.count();
+        conditionOrder.append(number);
+    }
+}
+
+/*
+ * parse conf_file into a new instance which is only used by applyConf(). No
+ * message box is shown, so that it could be called on a worker thread.
+ * Return NULL and set error if the file could not be parsed.
+ */
+Global* Global::loadConfFile(const QString& conf_file, bool write_cache,
+                             QString* error)
+{
+    QFileInfo fi(conf_file);
+    Global* conf = new Global();
+
+    conf->confFile = fi.absoluteFilePath();
+    conf->confModified = fi.lastModified();
+    conf->confSize = fi.size();
+
+    if(!conf->parseConfFile(error))
+    {
+        delete conf;
+        return NULL;
+    }
+
+    if(write_cache && !ClaCache::write(conf->confFile, conf))
+        Global::printText(stderr, QObject::tr(
+                    "[WARNING] Unable to write the cache of ") +
+                conf->confFile);
+
+    conf->prepareItems();
+
+    return conf;
+}
+
+/*
+ * replace what is loaded from the cla file with conf, which is deleted. Items
+ * whose definitions are unchanged are kept, so that pointers to them stay
+ * valid, only their numbers may change. The keys of the added and modified
+ * items are put into changed. The items which are replaced or removed are
+ * put into removed, they still have their old numbers, tab pages and rows,
+ * and must be deleted by the caller.
+ */
+void Global::applyConf(Global* conf, QSet<QString>* changed,
+                       QList<Global::Item*>* removed)
+{
+    ProfileScope profile("apply reloaded cla file");
+
+    confModified = conf->confModified;
+    confSize = conf->confSize;
+    windowTitle = conf->windowTitle;
+    command = conf->command;
+    tabs = conf->tabs;
+    about = conf->about;
+    claGeometry = conf->claGeometry;
+    redirections = conf->redirections;
+    claTerminals = conf->claTerminals;
+
+    QHash<QString, Global::Item*> old_items;
+    old_items.swap(itemsByKey);
+
+    int item_count = conf->items.count();
+    for(int i = 0; i < item_count; ++i)
+    {
+        Global::Item* item = conf->items.at(i);
+        Global::Item* old_item = old_items.take(item->key);
+
+        if(old_item && old_item->hasSameDefinition(*item))
+        {
+            old_item->number = item->number;
+            conf->items[i] = old_item;
+            delete item;
+        }
+        else
+        {
+            if(old_item)
+                removed->append(old_item);
+            changed->insert(item->key);
+        }
+
+        itemsByKey.insert(conf->items.at(i)->key, conf->items.at(i));
+    }
+
+    Q_FOREACH(Global::Item* item, old_items)
+        removed->append(item);
+
+    items.swap(conf->items);
+    conf->items.clear();
+    delete conf;
+
+    // the kept items may refer to items whose numbers have changed, the
+    // index is built again by the next search
+    compileConditions();
+    itemIndex.clear();
+    itemIndexBuilt = false;
+}
+
+/*
+ * index the words of the titles, keys and value templates of the items, so
+ * that searchItems() does not have to look at the items
+ */
+void Global::buildItemIndex()
+{
+    ProfileScope profile("build item index");
+
+    itemIndex.clear();
+    itemIndexBuilt = true;
+    Q_FOREACH(const Global::Item* item, items)
+    {
+        addToItemIndex(item->number, item->title);
+        addToItemIndex(item->number, item->key);
+        addToItemIndex(item->number, item->valueYes);
+        addToItemIndex(item->number, item->valueNo);
+        addToItemIndex(item->number, item->valueEmpty);
+        addToItemIndex(item->number, item->valueNonempty);
+        Q_FOREACH(const QString& value, item->listValues)
+            addToItemIndex(item->number, value);
+    }
+}
+
+static QStringList tokenize(const QString& text)
+{
+    return text.toLower().split(QRegExp("\\W+"), QString::SkipEmptyParts);
+}
+
+void Global::addToItemIndex(int number, const QString& text)
+{
+    Q_FOREACH(const QString& token, tokenize(text))
+    {
+        // the items are indexed one after another, so a token repeated in
+        // the same item could only be the last one
+        QVector<int>& numbers = itemIndex[token];
+        if(numbers.isEmpty() || numbers.last() != number)
+            numbers.append(number);
+    }
+}
+
+/*
+ * the numbers of the items matching every word of query, in increasing
+ * order. A word matches the beginning of any word of the title, the key or
+ * the value templates of an item. An empty query matches nothing. The index
+ * is built by the first search, only the search box needs it.
+ */
+QList<int> Global::searchItems(const QString& query)
+{
+    if(!itemIndexBuilt)
+        buildItemIndex();
+
+    QStringList words(tokenize(query));
+    QSet<int> matched;
+
+    for(int w = 0; w < words.size(); ++w)
+    {
+        QSet<int> word_matched;
+        const QString& word = words.at(w);
+        QMap<QString, QVector<int> >::const_iterator it =
+            itemIndex.lowerBound(word);
+
+        for(; it != itemIndex.constEnd() && it.key().startsWith(word); ++it)
+            Q_FOREACH(int number, it.value())
+                word_matched.insert(number);
+
+        // keep the items matching all the words so far
+        if(w == 0)
+            matched = word_matched;
+        else
+            matched.intersect(word_matched);
+
+        if(matched.isEmpty())
+            break;
+    }
+
+    QList<int> results(matched.toList());
+    qSort(results);
+    return results;
+}
+
+/*
+ * read a map of terminal names to the commands that start them, such as the
+ * "terminals" section of a cla file
+ */
+static void parseTerminals(const YAML::Node& node,
+                           QList<Global::Terminal>* terminals)
+{
+    if (!node.IsMap())
+        return;
+
+    for (YAML::Node::const_iterator it = node.begin(); it != node.end(); ++ it)
+    {
+        if (!it->second.IsScalar())
+            continue;
+
+        Global::Terminal term;
+        term.name = QString::fromStdString(it->first.as<std::string>());
+        term.cmd = QString::fromStdString(it->second.as<std::string>());
+        term.console = false;
+        terminals->append(term);
+    }
+}
+
+/*
+ * the terminals the command could be started in: those of the cla file, then
+ * those of the user configuration, then the built-in ones. Which of them are
+ * installed is found by TerminalFinder, the internal console and "no
+ * terminal" are always available.
+ */
+void Global::setupTerminals()
+{
+    ProfileScope profile("terminal setup");
+
+    Q_FOREACH(const Global::Terminal& term, claTerminals)
+        terminals.append(new Terminal(term));
+
+    QString user_conf(QStandardPaths::locate(
+                          QStandardPaths::GenericConfigLocation,
+                          "cmdlauncher/terminals.yaml"));
+    if(!user_conf.isEmpty())
+    {
+        try
+        {
+            QList<Global::Terminal> user_terminals;
+            parseTerminals(YAML::LoadFile(user_conf.toUtf8().constData()),
+                           &user_terminals);
+            Q_FOREACH(const Global::Terminal& term, user_terminals)
+                terminals.append(new Terminal(term));
+        } catch (YAML::Exception& e)
+        {
+            Global::printText(stderr, user_conf + ": " + e.what());
+        }
+    }
+
+    // the built-in terminals, the most common ones first. The arguments keep
+    // the terminal open after the command has finished where possible.
+    static const char* const builtin_terminals[][2] = {
+#ifdef Q_OS_WIN
+        { "cmd", "cmd /K" }
+#else
+        { "xterm", "xterm -hold -e" },
+        { "konsole", "konsole --hold -e" },
+        { "gnome-terminal", "gnome-terminal --wait --" },
+        { "xfce4-terminal", "xfce4-terminal --hold -x" },
+        { "mate-terminal", "mate-terminal -x" },
+        { "lxterminal", "lxterminal -e" },
+        { "terminator", "terminator -x" },
+        { "tilix", "tilix -e" },
+        { "alacritty", "alacritty --hold -e" },
+        { "kitty", "kitty --hold" },
+        { "foot", "foot --hold" },
+        { "wezterm", "wezterm start --" },
+        { "urxvt", "urxvt -hold -e" },
+        { "st", "st -e" }
+#endif
+    };
+
+    for(size_t i = 0;
+        i < sizeof(builtin_terminals) / sizeof(builtin_terminals[0]); ++i)
+    {
+        Terminal* tmpterm = new Terminal();
+        tmpterm->name = builtin_terminals[i][0];
+        tmpterm->cmd = builtin_terminals[i][1];
+        tmpterm->console = false;
+        terminals.append(tmpterm);
+    }
+
+    Terminal* tmpterm = new Terminal();
+    tmpterm->name = QObject::tr("internal console");
+    tmpterm->console = true;
+    terminals.append(tmpterm);
+
+    tmpterm = new Terminal();
+    tmpterm->name = QObject::tr("no terminal");
+    tmpterm->console = false;
+    terminals.append(tmpterm);
+}
+
+/*
+ * a fatal error: exit, unless the instance is resident in a daemon, which
+ * must keep running
+ */
+void Global::fail(int exit_code)
+{
+    if(!resident)
+        exit(exit_code);
+
+    failed = true;
+    exitCode = exit_code;
+}
+
+/*
+ * parse the command line arguments. Return whether the geometry has been set
+ * in the command line.
+ */
+bool Global::parseArguments(const QStringList& args)
+{
+    ProfileScope profile("parse arguments");
+
     // we don't need the first argument
+    QStringList arguments(args);
     arguments.pop_front();
     bool file_flag = false;
+    bool value_flag = false;
+    bool values_flag = false;
+    bool batch_flag = false;
+    bool jobs_flag = false;
     bool geometry_flag = false;
+    bool render_flag = false;
     // whether the geometry has been set in the command line
     bool geometry_set = false;
     Q_FOREACH(const QString& arg, arguments)
@@ -67,14 +654,84 @@ Global::Global()
             // set startup geometry from argument list
             startupGeometry = convertGeometryStringToRect(arg);
         }
+        else if(value_flag)
+        {
+            value_flag = false;
+            valueArguments.append(arg);
+        }
+        else if(values_flag)
+        {
+            values_flag = false;
+            valuesFile = arg;
+        }
+        else if(batch_flag)
+        {
+            batch_flag = false;
+            batchFile = arg;
+        }
+        else if(jobs_flag)
+        {
+            jobs_flag = false;
+            maxJobs = arg.toInt();
+        }
+        else if(render_flag)
+        {
+            render_flag = false;
+
+            if(arg == "auto")
+                renderMode = RENDERMODE_AUTO;
+            else if(arg == "widgets")
+                renderMode = RENDERMODE_WIDGETS;
+            else if(arg == "delegates")
+                renderMode = RENDERMODE_DELEGATES;
+            else
+            {
+                Global::printText(stderr, QObject::tr(
+                            "Unknown render mode ") + arg
+#ifdef Q_OS_WIN
+                        , MESSAGEBOXTYPE_CRITICAL
+#endif
+                        );
+
+                fail(1);
+                return geometry_set;
+            }
+        }
         else if(arg == "-f" || arg == "--file")
             file_flag = true;
         else if(arg == "--geometry")
             geometry_flag = true;
+        else if(arg == "--render")
+            render_flag = true;
+        else if(arg == "--print-cmd")
+            headlessMode = HEADLESSMODE_PRINT_CMD;
+        else if(arg == "--print-argv")
+            headlessMode = HEADLESSMODE_PRINT_ARGV;
+        else if(arg == "--value")
+            value_flag = true;
+        else if(arg == "--values")
+            values_flag = true;
+        else if(arg == "--batch")
+        {
+            headlessMode = HEADLESSMODE_BATCH;
+            batch_flag = true;
+        }
+        else if(arg == "--jobs" || arg == "-j")
+            jobs_flag = true;
+        else if(arg == "--profile-startup" ||
+                arg.startsWith("--profile-startup="))
+            ; // already handled in main()
+        else if(arg == "--daemon" || arg == "--no-daemon")
+            ; // already handled in main()
+        else if(arg == "--no-cache")
+            useCache = false;
+        else if(arg == "--rebuild-cache")
+            rebuildCache = true;
         else if(arg == "--help")
         {
             Global::printHelp();
-            exit(0);
+            fail(0);
+            return geometry_set;
         }
         else if(this->confFile.isEmpty())
             this->confFile = arg;
@@ -86,48 +743,29 @@ Global::Global()
 #endif
                     );
 
-            exit(1);
+            fail(1);
+            return geometry_set;
         }
     }
 
-    // if no cla file is specified, ask the user to choose one. If the user
-    // cancels, exit
-    if(confFile.isEmpty())
-    {
-        QString message(QObject::tr("You must specify a cla file"));
-
-        QMessageBox::information(NULL, QObject::tr("CmdLauncher"), message);
-
-        confFile = QFileDialog::getOpenFileName(NULL, message);
-
-        if(confFile.isEmpty())
-            exit(3);
-    }
-    // if the cla file is not readable, then we give an error message and exit
-    QFileInfo fi_ini(confFile);
-    if(!fi_ini.isReadable())
-    {
-        QString message(QObject::tr("Unable to load file") + " \"" +
-                confFile + "\". " + QObject::tr("Now Exit."));
-        printText(stderr, message
-#ifdef Q_OS_WIN
-                , MESSAGEBOXTYPE_CRITICAL
-#endif
-                );
-        exit(4);
-    }
+    return geometry_set;
+}
 
+/*
+ * parse the cla file with yaml-cpp
+ */
+bool Global::parseConfFile(QString* error)
+{
     // parse the config file
     YAML::Node config;
     try
     {
+        ProfileScope profile("YAML::LoadFile");
         config = YAML::LoadFile(this->confFile.toUtf8().constData());
     } catch (YAML::Exception& e)
     {
-        Global::printText(stderr, e.what());
-        QMessageBox(QMessageBox::Critical,
-                    QObject::tr("CmdLauncher"), e.what()).exec();
-        exit(5);
+        *error = QString::fromUtf8(e.what());
+        return false;
     }
 
 #define SET_VALUE(section, x, entry)       \
@@ -148,15 +786,16 @@ Global::Global()
         QString tabs;
         SET_VALUE(config_general, tabs, "tabs");
         this->tabs = tabs.split(',');
-        if(config_general["geometry"] && !geometry_set)
-            this->startupGeometry = convertGeometryStringToRect(
-                QString::fromStdString(
-                    config_general["geometry"].as<std::string>()));
+        SET_VALUE(config_general, this->claGeometry, "geometry");
+        SET_VALUE(config_general, redirections.stdinFile, "stdin");
+        SET_VALUE(config_general, redirections.stdoutFile, "stdout");
+        SET_VALUE(config_general, redirections.stderrFile, "stderr");
     }
 
     // "items" section
     if (config["items"])
     {
+        ProfileScope profile("convert items");
         YAML::Node config_items = config["items"];
 
         for (YAML::Node::const_iterator item = config_items.begin();
@@ -164,17 +803,29 @@ Global::Global()
         {
             // read them into a new Global::Item
             Global::Item* new_item = new Global::Item();
+            new_item->key = QString::fromStdString(
+                    item->first.as<std::string>());
 
             for (YAML::Node::const_iterator it = item->second.begin();
                  it != item->second.end(); ++ it)
-                (*new_item)[QString::fromStdString(
-                        it->first.as<std::string>())] =
-                    QString::fromStdString(it->second.as<std::string>());
+            {
+                // nested values are not used by CmdLauncher, skip them
+                // instead of failing on the conversion to string
+                if (!it->second.IsScalar())
+                    continue;
+
+                new_item->setValue(
+                        QString::fromStdString(it->first.as<std::string>()),
+                        QString::fromStdString(it->second.as<std::string>()));
+            }
 
             this->items.append(new_item);
         }
     }
 
+    // "terminals" section
+    parseTerminals(config["terminals"], &claTerminals);
+
     // "about" section
     if (config["about"] && config["about"].IsMap())
     {
@@ -192,84 +843,398 @@ Global::Global()
 
 #undef SET_VALUE
 
-    // sort items according to "order"
-    qSort(items.begin(), items.end(), Global::lessThanItemsOrder);
-    // after sort the items according to "order", give them a number
-    int item_count = items.count();
-    for(int i = 0; i < item_count; ++i)
-        (*items.at(i))["No."] = i;
+    return true;
+}
 
-    // terminal information
-    Terminal* tmpterm;
+/*
+ * normalize "order" or "displayorder": if the number is less than 0 and it is
+ * not -1, set it to 0
+ */
+static int normalizeOrder(int order)
+{
+    if(order < 0 && order != -1)
+        return 0;
 
-#ifdef Q_OS_WIN
-    tmpterm = new Terminal();
-    tmpterm->name = "cmd";
-    tmpterm->cmd = "cmd /K";
-    terminals.append(tmpterm);
-#else
-    tmpterm = new Terminal();
-    tmpterm->name = "xterm";
-    tmpterm->cmd = "xterm -hold -e";
-    terminals.append(tmpterm);
+    return order;
+}
 
-    tmpterm = new Terminal();
-    tmpterm->name = "konsole";
-    tmpterm->cmd = "konsole --hold -e";
-    terminals.append(tmpterm);
-#endif
+Global::Item::Item() :
+    type(TYPE_UNKNOWN),
+    order(-1),
+    displayorder(-1),
+    filemode("file"),
+    mustExist(true),
+    mustNotEmpty(false),
+    number(-1),
+    tabpage(0),
+    row(0),
+    hasMinimum(false),
+    hasMaximum(false),
+    minimumValue(0),
+    maximumValue(0),
+    existsMode(EXISTS_NONE)
+{
 }
 
 /*
- * the "less than" function of the Global::Item by "order"
+ * compile the value templates, after all keys have been set
  */
-bool Global::lessThanItemsOrder(
-    const Global::Item* i1, const Global::Item* i2)
+void Global::Item::compileTemplates()
 {
-    int a = i1->value("order", -1).toInt();
-    int b = i2->value("order", -1).toInt();
+    yesTemplate = ValueTemplate(valueYes, false);
+    noTemplate = ValueTemplate(valueNo, false);
+    emptyTemplate = ValueTemplate(valueEmpty, false);
+    nonemptyTemplate = ValueTemplate(valueNonempty);
 
-    // if the numbers are less than 0 and they are not -1, set them to 0
-    if(a < 0 && a != -1)
-        a = 0;
-    if(b < 0 && b != -1)
-        b = 0;
+    listTemplates.clear();
 
-    if(b == -1)
-        return false;
+    // the entries of a "list-cmd" item are not known in advance. Unless
+    // "value/n" is given, they are rendered with "value/nonempty", in which
+    // %a is the entry, or as they are.
+    if(!listCmd.isEmpty())
+    {
+        int count = list.count();
+        listTemplates.reserve(count);
+        for(int i = 0; i < count; ++i)
+        {
+            const QString& value = listValues.value(i);
+            if(!value.isEmpty())
+                listTemplates.append(ValueTemplate(value, false));
+            else
+                listTemplates.append(ValueTemplate(
+                        valueNonempty.isEmpty() ? "%a" : valueNonempty));
+        }
+        return;
+    }
 
-    return a < b;
+    listTemplates.reserve(listValues.count());
+    Q_FOREACH(const QString& value, listValues)
+        listTemplates.append(ValueTemplate(value, false));
 }
 
 /*
- * the "less than" function of the Global::Item by "displayorder"
+ * compile the checks of the text, after all keys have been set. The regular
+ * expression must match the whole text.
  */
-bool Global::lessThanItemsDisplayorder(
-    const Global::Item* i1, const Global::Item* i2)
+void Global::Item::compileValidation()
 {
-    int a = i1->value("displayorder", -1).toInt();
-    int b = i2->value("displayorder", -1).toInt();
+    validateRegExp = QRegularExpression();
+    if(!validate.isEmpty())
+    {
+        validateRegExp = QRegularExpression("\\A(?:" + validate + ")\\z");
+        if(validateRegExp.isValid())
+            validateRegExp.optimize();
+        else
+        {
+            Global::printText(stderr, QObject::tr("[WARNING] Item \"") + key +
+                              QObject::tr("\": invalid validate: ") +
+                              validateRegExp.errorString());
+            validateRegExp = QRegularExpression();
+        }
+    }
 
-    // if the numbers are less than 0 and they are not -1, set them to 0
-    if(a < 0 && a != -1)
-        a = 0;
-    if(b < 0 && b != -1)
-        b = 0;
+    minimumValue = minimum.toDouble(&hasMinimum);
+    maximumValue = maximum.toDouble(&hasMaximum);
 
-    if(b == -1)
-        return false;
+    if(exists.isEmpty())
+        existsMode = EXISTS_NONE;
+    else if(exists == "file")
+        existsMode = EXISTS_FILE;
+    else if(exists == "dir")
+        existsMode = EXISTS_DIR;
+    else
+        existsMode = stringToBool(exists) ? EXISTS_ANY : EXISTS_NONE;
+}
+
+/*
+ * whether the text of the item is checked
+ */
+bool Global::Item::hasValidation() const
+{
+    return (type == TYPE_TEXT || type == TYPE_FILE) &&
+            (!validateRegExp.pattern().isEmpty() || hasMinimum ||
+             hasMaximum || existsMode != EXISTS_NONE);
+}
+
+/*
+ * replace the entries of a list item, e.g. with the output of "list-cmd"
+ */
+void Global::Item::setList(const QStringList& entries)
+{
+    list = entries;
+    compileTemplates();
+}
+
+/*
+ * show text as the only entry of a list item while its entries are not
+ * known. Nothing is added to the command for it.
+ */
+void Global::Item::setListPlaceholder(const QString& text)
+{
+    list = QStringList(text);
+    listTemplates.clear();
+}
+
+/*
+ * set the value of key k read from the cla file
+ */
+void Global::Item::setValue(const QString& k, const QString& value)
+{
+    if(k == "type")
+    {
+        if(value == "bool")
+            type = TYPE_BOOL;
+        else if(value == "text")
+            type = TYPE_TEXT;
+        else if(value == "list")
+            type = TYPE_LIST;
+        else if(value == "file")
+            type = TYPE_FILE;
+        else
+            type = TYPE_UNKNOWN;
+    }
+    else if(k == "title")
+        title = value;
+    else if(k == "tab")
+        tab = value;
+    else if(k == "default")
+        defaultValue = value;
+    else if(k == "order")
+        order = normalizeOrder(value.toInt());
+    else if(k == "displayorder")
+        displayorder = normalizeOrder(value.toInt());
+    else if(k == "list")
+    {
+        list = value.split(',');
+        staticList = list;
+    }
+    else if(k == "list-cmd")
+        listCmd = value;
+    else if(k == "value/yes")
+        valueYes = value;
+    else if(k == "value/no")
+        valueNo = value;
+    else if(k == "value/empty")
+        valueEmpty = value;
+    else if(k == "value/nonempty")
+        valueNonempty = value;
+    else if(k == "dir")
+        dir = value;
+    else if(k == "filter")
+        filter = value;
+    else if(k == "filemode")
+        filemode = value;
+    else if(k == "mustexist")
+        mustExist = stringToBool(value);
+    else if(k == "mustnotempty")
+        mustNotEmpty = stringToBool(value);
+    else if(k == "validate")
+        validate = value;
+    else if(k == "min")
+        minimum = value;
+    else if(k == "max")
+        maximum = value;
+    else if(k == "exists")
+        exists = value;
+    else if(k == "enabledif")
+        enabledIf = value;
+    else if(k == "visibleif")
+        visibleIf = value;
+    else
+    {
+        // "value/n" of list items
+        bool ok = false;
+        int n = -1;
+        if(k.startsWith("value/"))
+            n = k.mid(6).toInt(&ok);
+
+        if(ok && n >= 0)
+        {
+            while(listValues.count() <= n)
+                listValues.append(QString());
+            listValues[n] = value;
+        }
+        else
+            extra.insert(k, value);
+    }
+}
+
+/*
+ * the value of the item before the user changes it: a bool for bool items, the
+ * selected index for list items, and a string for text and file items
+ */
+QVariant Global::Item::initialValue() const
+{
+    switch(type)
+    {
+    case TYPE_BOOL:
+        return stringToBool(defaultValue);
+    case TYPE_LIST:
+        return defaultValue.toInt();
+    case TYPE_TEXT:
+    case TYPE_FILE:
+        return defaultValue;
+    default:
+        return QVariant();
+    }
+}
+
+/*
+ * convert a value given as a string, e.g. on the command line, to a value of
+ * the item. List items accept either the index or the text of an entry.
+ * Return an invalid QVariant if str is not a valid value.
+ */
+QVariant Global::Item::valueFromString(const QString& str) const
+{
+    switch(type)
+    {
+    case TYPE_BOOL:
+        return stringToBool(str);
+    case TYPE_LIST:
+    {
+        bool ok = false;
+        int index = str.toInt(&ok);
+        if(!ok)
+            index = list.indexOf(str);
+        if(index < 0 || index >= list.count())
+            return QVariant();
+        return index;
+    }
+    case TYPE_TEXT:
+    case TYPE_FILE:
+        return str;
+    default:
+        return QVariant();
+    }
+}
+
+/*
+ * convert a value of another definition of the item, e.g. before the cla
+ * file has been edited, to a value of the item. Return an invalid QVariant if
+ * value does not fit the item.
+ */
+QVariant Global::Item::fitValue(const QVariant& value) const
+{
+    switch(type)
+    {
+    case TYPE_BOOL:
+        return value.toBool();
+    case TYPE_LIST:
+    {
+        bool ok = false;
+        int index = value.toInt(&ok);
+        if(!ok || index < 0 || index >= list.count())
+            return QVariant();
+        return index;
+    }
+    case TYPE_TEXT:
+    case TYPE_FILE:
+        return value.toString();
+    default:
+        return QVariant();
+    }
+}
+
+/*
+ * whether the item is defined in the same way as other in the cla file
+ */
+bool Global::Item::hasSameDefinition(const Global::Item& other) const
+{
+    return key == other.key && type == other.type && title == other.title &&
+            tab == other.tab && defaultValue == other.defaultValue &&
+            order == other.order && displayorder == other.displayorder &&
+            staticList == other.staticList && listCmd == other.listCmd &&
+            listValues == other.listValues &&
+            valueYes == other.valueYes && valueNo == other.valueNo &&
+            valueEmpty == other.valueEmpty &&
+            valueNonempty == other.valueNonempty && dir == other.dir &&
+            filter == other.filter && filemode == other.filemode &&
+            mustExist == other.mustExist &&
+            mustNotEmpty == other.mustNotEmpty &&
+            enabledIf == other.enabledIf && visibleIf == other.visibleIf &&
+            validate == other.validate && minimum == other.minimum &&
+            maximum == other.maximum && exists == other.exists &&
+            extra == other.extra;
+}
+
+/*
+ * convert a string in the cla file to bool, the same way as QVariant does
+ */
+bool Global::stringToBool(const QString& str)
+{
+    return !(str.isEmpty() || str == "0" ||
+             str.compare("false", Qt::CaseInsensitive) == 0);
+}
+
+QDataStream& operator<<(QDataStream& out, const Global::Item& item)
+{
+    out << item.key << qint32(item.type) << item.title << item.tab
+        << item.defaultValue << qint32(item.order) << qint32(item.displayorder)
+        << item.list << item.listValues << item.valueYes << item.valueNo
+        << item.valueEmpty << item.valueNonempty << item.dir << item.filter
+        << item.filemode << item.mustExist << item.mustNotEmpty << item.extra
+        << item.enabledIf << item.visibleIf << item.listCmd
+        << item.validate << item.minimum << item.maximum << item.exists;
+
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, Global::Item& item)
+{
+    qint32 type, order, displayorder;
 
-    return a < b;
+    in >> item.key >> type >> item.title >> item.tab
+        >> item.defaultValue >> order >> displayorder
+        >> item.list >> item.listValues >> item.valueYes >> item.valueNo
+        >> item.valueEmpty >> item.valueNonempty >> item.dir >> item.filter
+        >> item.filemode >> item.mustExist >> item.mustNotEmpty >> item.extra
+        >> item.enabledIf >> item.visibleIf >> item.listCmd
+        >> item.validate >> item.minimum >> item.maximum >> item.exists;
+    item.staticList = item.list;
+
+    item.type = static_cast<enum Global::Item::Type>(type);
+    item.order = order;
+    item.displayorder = displayorder;
+
+    return in;
 }
 
-Global* Global::getInstance()
+QDataStream& operator<<(QDataStream& out, const Global::Terminal& term)
 {
-    static Global* gi = NULL;
+    return out << term.name << term.cmd << term.console;
+}
 
-    if(!gi)
-        gi = new Global();
+QDataStream& operator>>(QDataStream& in, Global::Terminal& term)
+{
+    return in >> term.name >> term.cmd >> term.console;
+}
 
-    return gi;
+/*
+ * the "less than" function of the Global::Item by "order". Since negative
+ * numbers other than -1 have been set to 0 when the item is loaded, this is a
+ * plain integer comparison.
+ */
+bool Global::lessThanItemsOrder(
+    const Global::Item* i1, const Global::Item* i2)
+{
+    return i1->order < i2->order;
+}
+
+/*
+ * the "less than" function of the Global::Item by "displayorder"
+ */
+bool Global::lessThanItemsDisplayorder(
+    const Global::Item* i1, const Global::Item* i2)
+{
+    return i1->displayorder < i2->displayorder;
+}
+
+/*
+ * whether there is a QApplication, i.e. whether widgets could be shown
+ */
+bool Global::hasGui()
+{
+    return qobject_cast<QApplication*>(QCoreApplication::instance()) != NULL;
 }
 
 const QList<Global::Item*>* Global::getItems()
@@ -277,6 +1242,11 @@ const QList<Global::Item*>* Global::getItems()
     return &this->items;
 }
 
+const Global::Item* Global::getItem(const QString& key)
+{
+    return itemsByKey.value(key, NULL);
+}
+
 const QString* Global::getCommand()
 {
     return &this->command;
@@ -287,8 +1257,16 @@ const QStringList* Global::getTabs()
     return &this->tabs;
 }
 
+/*
+ * the terminals are set up the first time they are needed, so that the
+ * headless and batch modes, which don't use them, never read the user
+ * configuration
+ */
 const QList<Global::Terminal*>* Global::getTerminals()
 {
+    if(terminals.isEmpty())
+        setupTerminals();
+
     return &this->terminals;
 }
 
@@ -306,8 +1284,65 @@ void Global::setItemTabpageRow(int index, int tab, int row)
 {
     Global::Item* item = this->items[index];
 
-    item->insert("tabpage", tab);
-    item->insert("row", row);
+    item->tabpage = tab;
+    item->row = row;
+}
+
+const QVector<QVector<int> >* Global::getConditionDependents()
+{
+    return &conditionDependents;
+}
+
+const QVector<int>* Global::getConditionOrder()
+{
+    return &conditionOrder;
+}
+
+const QVector<int>* Global::getConditionRanks()
+{
+    return &conditionRanks;
+}
+
+bool Global::getUseCache()
+{
+    return useCache;
+}
+
+void Global::setItemList(int index, const QStringList& entries)
+{
+    items[index]->setList(entries);
+}
+
+void Global::setItemListPlaceholder(int index, const QString& text)
+{
+    items[index]->setListPlaceholder(text);
+}
+
+/*
+ * the absolute path of the cla file
+ */
+const QString* Global::getConfFile()
+{
+    return &confFile;
+}
+
+/*
+ * the current directory when the instance was created, in which the command
+ * is started
+ */
+const QString* Global::getWorkingDir()
+{
+    return &workingDir;
+}
+
+bool Global::hasFailed()
+{
+    return failed;
+}
+
+int Global::getExitCode()
+{
+    return exitCode;
 }
 
 const QString Global::getHelpMessage()
@@ -321,7 +1356,50 @@ const QString Global::getHelpMessage()
             " Format is like this: widthxheight+x+y.\n"
             "                         Example: 800x600+50+50\n"
             "--file  or  -f           The cla file specified\n"
+            "--render MODE            How the items are displayed: auto,"
+            " widgets or delegates.\n"
+            "                         Default is auto, which uses delegates"
+            " for large cla files\n"
+            "--no-cache               Do not use the binary cache of the cla"
+            " file\n"
+            "--rebuild-cache          Ignore the binary cache of the cla file"
+            " and rebuild it\n"
+            "--profile-startup[=FILE] Print the time spent in each phase of"
+            " startup, or write it\n"
+            "                         to FILE as JSON\n"
+            "--daemon                 Stay resident and open the windows of"
+            " later invocations,\n"
+            "                         which hand their arguments to the daemon"
+            " and exit\n"
+            "--no-daemon              Open the window in this process even if"
+            " a daemon is running\n"
+            "--catalog DIR            Search the cla files under DIR and open"
+            " the chosen ones\n"
             "--help                   Print this help message\n"
+            "\n"
+            "Options for using the cla file without the window:\n"
+            "\n"
+            "--print-cmd              Print the final command and exit\n"
+            "--print-argv             Print the arguments of the final"
+            " command separated by NUL\n"
+            "                         and exit\n"
+            "--value KEY=VALUE        Set the value of the item KEY. Bool"
+            " items take 1 or 0,\n"
+            "                         list items take the index or the text of"
+            " an entry\n"
+            "--values FILE            Read the values of the items from a JSON"
+            " object in FILE,\n"
+            "                         or from stdin if FILE is -\n"
+            "--batch FILE             Run the command once for each record of"
+            " values in FILE,\n"
+            "                         or in stdin if FILE is -. Records are"
+            " JSON objects, one\n"
+            "                         per line, or tab separated values whose"
+            " first line is\n"
+            "                         the keys of the items\n"
+            "--jobs N  or  -j N       Run at most N commands of --batch at the"
+            " same time.\n"
+            "                         Default is the number of CPU cores\n"
             );
 }
 
@@ -342,6 +1420,41 @@ const QRect* Global::getStartupGeometry()
     return &startupGeometry;
 }
 
+const Spawner::Redirections* Global::getRedirections()
+{
+    return &redirections;
+}
+
+enum Global::RenderMode Global::getRenderMode()
+{
+    return renderMode;
+}
+
+enum Global::HeadlessMode Global::getHeadlessMode()
+{
+    return headlessMode;
+}
+
+const QStringList* Global::getValueArguments()
+{
+    return &valueArguments;
+}
+
+const QString* Global::getValuesFile()
+{
+    return &valuesFile;
+}
+
+const QString* Global::getBatchFile()
+{
+    return &batchFile;
+}
+
+int Global::getMaxJobs()
+{
+    return maxJobs;
+}
+
 /*
  * convert geometry string to a QRect
  */
@@ -375,7 +1488,7 @@ void Global::printText(QTextStream* s, const QString& str,
 {
     (*s) << prefix + str << endl;
 
-    if(dialog_type == MESSAGEBOXTYPE_NO_MESSAGE_BOX)
+    if(dialog_type == MESSAGEBOXTYPE_NO_MESSAGE_BOX || !hasGui())
         return;
 
     enum QMessageBox::Icon dialog_icon;
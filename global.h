@@ -23,31 +23,164 @@
 #ifndef GLOBAL_H
 #define GLOBAL_H
 
+#include <QDataStream>
+#include <QDateTime>
 #include <QHash>
 #include <QList>
+#include <QMap>
 #include <QRect>
+#include <QRegularExpression>
+#include <QSet>
 #include <QString>
 #include <QStringList>
 #include <QTextStream>
 #include <QVariant>
+#include <QVector>
+#include "condition.h"
+#include "spawner.h"
+#include "valuetemplate.h"
 
 class Global
 {
-private:
-    Global();
+    friend class ClaCache;
+
+public:
+    Global(const QStringList& arguments,
+           const QHash<QString, Global*>* loaded = NULL);
+    ~Global();
 
 public:
-    typedef QHash<QString, QVariant> Item;
+    // an item in the items section of the cla file. The commonly used keys
+    // are parsed into typed fields when the item is loaded, so that they
+    // don't need to be looked up by strings afterwards.
+    struct Item
+    {
+        enum Type
+        {
+            TYPE_UNKNOWN = 0,
+            TYPE_BOOL,
+            TYPE_TEXT,
+            TYPE_LIST,
+            TYPE_FILE
+        };
+
+        QString key; // the key of the item in the items section
+        enum Type type;
+        QString title;
+        QString tab;
+        QString defaultValue;
+        // "order" and "displayorder", negative numbers other than -1 are
+        // already set to 0
+        int order;
+        int displayorder;
+
+        QStringList list; // entries of a list item
+        QStringList staticList; // "list", list may be filled by listCmd
+        QString listCmd; // "list-cmd", its output lines are the entries
+        QStringList listValues; // "value/n" of a list item, indexed by n
+        QString valueYes;
+        QString valueNo;
+        QString valueEmpty;
+        QString valueNonempty;
+
+        QString dir;
+        QString filter;
+        QString filemode;
+        bool mustExist;
+        bool mustNotEmpty;
+        QString enabledIf; // "enabledif", see Condition
+        QString visibleIf; // "visibleif"
+
+        // checks of the text of text and file items, see ItemValidator
+        QString validate; // a regular expression the text must match
+        QString minimum; // the text must be a number in [minimum, maximum]
+        QString maximum;
+        QString exists; // the path must exist: "file", "dir" or a bool
+
+        // set when the items are sorted and displayed
+        int number; // the index after the items are sorted by "order"
+        int tabpage;
+        int row;
+
+        // keys which are not known to CmdLauncher
+        QHash<QString, QString> extra;
+
+        // compiled value templates, set by compileTemplates(). Only
+        // "value/nonempty" has placeholders.
+        ValueTemplate yesTemplate;
+        ValueTemplate noTemplate;
+        ValueTemplate emptyTemplate;
+        ValueTemplate nonemptyTemplate;
+        QVector<ValueTemplate> listTemplates;
+
+        // compiled checks, set by compileValidation()
+        enum ExistsMode
+        {
+            EXISTS_NONE = 0,
+            EXISTS_ANY,
+            EXISTS_FILE,
+            EXISTS_DIR
+        };
+        QRegularExpression validateRegExp;
+        bool hasMinimum;
+        bool hasMaximum;
+        double minimumValue;
+        double maximumValue;
+        enum ExistsMode existsMode;
+
+        // compiled conditions, set by Global::compileConditions()
+        Condition enabledCondition;
+        Condition visibleCondition;
+
+        Item();
+        void compileTemplates();
+        void compileValidation();
+        bool hasValidation() const;
+        void setList(const QStringList& entries);
+        void setListPlaceholder(const QString& text);
+        void setValue(const QString& k, const QString& value);
+        QVariant initialValue() const;
+        QVariant valueFromString(const QString& str) const;
+        QVariant fitValue(const QVariant& value) const;
+        bool hasSameDefinition(const Item& other) const;
+    };
 
-    static Global* getInstance();
+    // how the values of the items are displayed in the main window
+    enum RenderMode
+    {
+        RENDERMODE_AUTO = 0, // decided by the number of items
+        RENDERMODE_WIDGETS, // a live widget on each row
+        RENDERMODE_DELEGATES // painted by a delegate, editors created lazily
+    };
+
+    // what to do when no window is shown
+    enum HeadlessMode
+    {
+        HEADLESSMODE_NONE = 0, // show the main window
+        HEADLESSMODE_PRINT_CMD, // print the final command
+        HEADLESSMODE_PRINT_ARGV, // print the arguments, separated by NUL
+        HEADLESSMODE_BATCH // run the command once for each record of values
+    };
+
+    static bool stringToBool(const QString& str);
+
+    static Global* loadConfFile(const QString& conf_file, bool write_cache,
+                                QString* error);
+    void applyConf(Global* conf, QSet<QString>* changed,
+                   QList<Global::Item*>* removed);
+
+    static bool hasGui();
     static void printHelp();
     static const QString getHelpMessage();
 
-    // terminal information
+    // terminal information. An empty cmd means the command is started
+    // directly, without any terminal, or in the internal console if console
+    // is set.
     struct Terminal
     {
         QString name;
         QString cmd;
+        bool console;
     };
 
     struct About
@@ -62,13 +195,62 @@ public:
 
 private:
     QString confFile;
+    QDateTime confModified; // time stamp of the cla file when it was loaded
+    qint64 confSize;
+    QString workingDir; // current directory when the instance was created
     QString windowTitle;
     QString command;
     QStringList tabs;
     QList<Global::Item*> items;
+    QHash<QString, Global::Item*> itemsByKey;
+    // the items whose conditions refer to each item, indexed by number
+    QVector<QVector<int> > conditionDependents;
+    // the numbers of the items with conditions, in topological order, and
+    // the position of each item in this order, -1 for items without
+    QVector<int> conditionOrder;
+    QVector<int> conditionRanks;
+    // lowercase token of the titles, keys and value templates -> the
+    // numbers of the items containing it, in increasing order. A QMap, so
+    // that the tokens starting with a prefix are next to each other. It is
+    // built by the first search, see searchItems().
+    QMap<QString, QVector<int> > itemIndex;
+    bool itemIndexBuilt;
     QList<Global::Terminal*> terminals;
+    // terminals defined in the "terminals" section of the cla file
+    QList<Global::Terminal> claTerminals;
     Global::About about;
     QRect startupGeometry; // startup geometry
+    QString claGeometry; // geometry specified in the cla file
+    // redirections used when the command is started without terminal
+    Spawner::Redirections redirections;
+
+    enum RenderMode renderMode;
+    enum HeadlessMode headlessMode;
+    QStringList valueArguments; // "key=value" given with --value
+    QString valuesFile; // JSON file given with --values
+    QString batchFile; // records of values given with --batch
+    int maxJobs; // maximum number of concurrent batch jobs, 0 for auto
+
+    bool useCache; // whether the binary cache of the cla file is used
+    bool rebuildCache; // whether the binary cache is rebuilt
+
+    // a resident instance is created by the daemon, fatal errors don't exit
+    // the program but are reported by hasFailed()
+    bool resident;
+    bool failed;
+    int exitCode;
+
+    Global();
+
+    bool parseArguments(const QStringList& arguments);
+    bool parseConfFile(QString* error);
+    void prepareItems();
+    void compileConditions();
+    void buildItemIndex();
+    void addToItemIndex(int number, const QString& text);
+    void copyConfFrom(const Global* other);
+    void setupTerminals();
+    void fail(int exit_code);
 
 public:
     static bool lessThanItemsOrder(
@@ -98,13 +280,37 @@ protected:
 
 public:
     const QList<Global::Item*>* getItems();
+    const Global::Item* getItem(const QString& key);
+    QList<int> searchItems(const QString& query);
+    const QVector<QVector<int> >* getConditionDependents();
+    const QVector<int>* getConditionOrder();
+    const QVector<int>* getConditionRanks();
     const QString* getCommand();
     const QStringList* getTabs();
     const QString* getWindowTitle();
     const QList<Global::Terminal*>* getTerminals();
     const Global::About* getAbout();
     const QRect* getStartupGeometry();
+    const Spawner::Redirections* getRedirections();
+    enum RenderMode getRenderMode();
+    enum HeadlessMode getHeadlessMode();
+    const QStringList* getValueArguments();
+    const QString* getValuesFile();
+    const QString* getBatchFile();
+    int getMaxJobs();
+    bool getUseCache();
+    const QString* getConfFile();
+    const QString* getWorkingDir();
+    bool hasFailed();
+    int getExitCode();
     void setItemTabpageRow(int index, int tabpage, int row);
+    void setItemList(int index, const QStringList& entries);
+    void setItemListPlaceholder(int index, const QString& text);
 };
 
+QDataStream& operator<<(QDataStream& out, const Global::Item& item);
+QDataStream& operator>>(QDataStream& in, Global::Item& item);
+QDataStream& operator<<(QDataStream& out, const Global::Terminal& term);
+QDataStream& operator>>(QDataStream& in, Global::Terminal& term);
+
 #endif // GLOBAL_H
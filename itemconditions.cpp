@@ -0,0 +1,133 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "itemconditions.h"
+#include <QMap>
+
+ItemConditions::ItemConditions(Global* global) :
+    global(global)
+{
+}
+
+/*
+ * evaluate the conditions of all items with values, indexed by
+ * Global::Item::number
+ */
+void ItemConditions::setValues(const QVector<QVariant>& values)
+{
+    int count = global->getItems()->count();
+
+    this->values = values;
+    this->values.resize(count);
+    enabled.fill(true, count);
+    visible.fill(true, count);
+    active.fill(true, count);
+
+    Q_FOREACH(int number, *global->getConditionOrder())
+        evaluate(number);
+}
+
+/*
+ * change the value of an item and evaluate the conditions which depend on
+ * it. The numbers of the items whose state has changed are appended to
+ * changed.
+ */
+void ItemConditions::setValue(int number, const QVariant& value,
+                              QList<int>* changed)
+{
+    if(number < 0 || number >= values.count())
+        return;
+
+    values[number] = value;
+
+    // an inactive item evaluates to nothing whatever its value is
+    if(!active.testBit(number))
+        return;
+
+    const QVector<QVector<int> >* dependents =
+        global->getConditionDependents();
+    const QVector<int>* ranks = global->getConditionRanks();
+
+    // the items to evaluate, ordered by their topological ranks
+    QMap<int, int> queue;
+    Q_FOREACH(int dependent, dependents->at(number))
+        queue.insert(ranks->at(dependent), dependent);
+
+    while(!queue.isEmpty())
+    {
+        int next = queue.take(queue.firstKey());
+        bool was_active = active.testBit(next);
+
+        if(!evaluate(next))
+            continue;
+
+        changed->append(next);
+
+        // the items depending on it see another value only if it has been
+        // activated or deactivated
+        if(active.testBit(next) != was_active)
+            Q_FOREACH(int dependent, dependents->at(next))
+                queue.insert(ranks->at(dependent), dependent);
+    }
+}
+
+/*
+ * whether the item is enabled. Items unknown when the values were set, e.g.
+ * while the cla file is being reloaded, are enabled.
+ */
+bool ItemConditions::isEnabled(int number) const
+{
+    return number >= enabled.size() || enabled.testBit(number);
+}
+
+bool ItemConditions::isVisible(int number) const
+{
+    return number >= visible.size() || visible.testBit(number);
+}
+
+/*
+ * the items which are enabled and visible, indexed by Global::Item::number
+ */
+const QBitArray* ItemConditions::getActive() const
+{
+    return &active;
+}
+
+/*
+ * evaluate the conditions of an item. Return whether its state has changed.
+ */
+bool ItemConditions::evaluate(int number)
+{
+    const Global::Item* item = global->getItems()->at(number);
+    bool is_enabled = item->enabledCondition.evaluate(values, active);
+    bool is_visible = item->visibleCondition.evaluate(values, active);
+
+    if(is_enabled == enabled.testBit(number) &&
+            is_visible == visible.testBit(number))
+        return false;
+
+    enabled.setBit(number, is_enabled);
+    visible.setBit(number, is_visible);
+    active.setBit(number, is_enabled && is_visible);
+
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ITEMCONDITIONS_H
+#define ITEMCONDITIONS_H
+
+#include <QBitArray>
+#include <QList>
+#include <QVariant>
+#include <QVector>
+#include "global.h"
+
+// the state of the "enabledif" and "visibleif" conditions of the items for a
+// set of values. When the value of an item changes, only the items whose
+// conditions depend on it, directly or through other conditions, are
+// evaluated again, in topological order.
+class ItemConditions
+{
+public:
+    ItemConditions(Global* global);
+
+    void setValues(const QVector<QVariant>& values);
+    void setValue(int number, const QVariant& value, QList<int>* changed);
+
+    bool isEnabled(int number) const;
+    bool isVisible(int number) const;
+    const QBitArray* getActive() const;
+
+private:
+    Global* global;
+    QVector<QVariant> values; // indexed by Global::Item::number
+    QBitArray enabled;
+    QBitArray visible;
+    QBitArray active; // enabled and visible, used in the command
+
+    bool evaluate(int number);
+};
+
+#endif // ITEMCONDITIONS_H
@@ -0,0 +1,393 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "itemdelegate.h"
+#include <QApplication>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QStyle>
+#include <QStyleOptionButton>
+#include <QStyleOptionComboBox>
+#include "fileselector.h"
+#include "listselector.h"
+
+ItemDelegate::ItemDelegate(const QList<Global::Item*>* items,
+                           QObject* parent) :
+    QStyledItemDelegate(parent),
+    items(items)
+{
+}
+
+/*
+ * get the item displayed at index, or NULL if index is not a value cell
+ */
+const Global::Item* ItemDelegate::getItem(const QModelIndex& index) const
+{
+    bool ok = false;
+    int n = index.data(ROLE_ITEM).toInt(&ok);
+
+    if(!ok || n < 0 || n >= items->count())
+        return NULL;
+
+    return items->at(n);
+}
+
+void ItemDelegate::paint(QPainter* painter,
+                         const QStyleOptionViewItem& option,
+                         const QModelIndex& index) const
+{
+    const Global::Item* item = getItem(index);
+
+    if(!item)
+    {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    QStyleOptionViewItem opt(option);
+    initStyleOption(&opt, index);
+    const QWidget* widget = opt.widget;
+    QStyle* style = widget ? widget->style() : QApplication::style();
+    const QVariant value = index.data(ROLE_VALUE);
+
+    // draw the background of the cell first
+    if(item->type == Global::Item::TYPE_TEXT ||
+            item->type == Global::Item::TYPE_FILE)
+        opt.text = value.toString();
+    else
+        opt.text.clear();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+    // the view clears State_Enabled for the rows disabled by their
+    // conditions, the controls are drawn disabled too
+    QStyle::State enabled_state = option.state & QStyle::State_Enabled;
+
+    switch(item->type)
+    {
+    case Global::Item::TYPE_BOOL:
+    {
+        QStyleOptionButton check;
+        check.rect = option.rect.adjusted(3, 0, 0, 0);
+        check.rect = style->subElementRect(
+                    QStyle::SE_CheckBoxIndicator, &check, widget);
+        check.state = enabled_state |
+                (value.toBool() ? QStyle::State_On : QStyle::State_Off);
+        style->drawPrimitive(
+                    QStyle::PE_IndicatorCheckBox, &check, painter, widget);
+        break;
+    }
+    case Global::Item::TYPE_LIST:
+    {
+        QStyleOptionComboBox combo;
+        combo.rect = option.rect;
+        combo.state = enabled_state;
+        combo.frame = true;
+        combo.currentText = item->list.value(value.toInt());
+        style->drawComplexControl(
+                    QStyle::CC_ComboBox, &combo, painter, widget);
+        style->drawControl(QStyle::CE_ComboBoxLabel, &combo, painter, widget);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+QWidget* ItemDelegate::createEditor(QWidget* parent,
+                                    const QStyleOptionViewItem& option,
+                                    const QModelIndex& index) const
+{
+    Q_UNUSED(option);
+
+    const Global::Item* item = getItem(index);
+
+    // bool items are toggled in editorEvent and don't need an editor
+    if(!item || item->type == Global::Item::TYPE_BOOL)
+        return NULL;
+
+    QWidget* editor = createWidget(item, parent);
+
+    if(!editor)
+        return NULL;
+
+    editor->setAutoFillBackground(true);
+    connectWidgetChanged(editor, item, this, SLOT(commitEditor()));
+
+    return editor;
+}
+
+void ItemDelegate::setEditorData(QWidget* editor,
+                                 const QModelIndex& index) const
+{
+    const Global::Item* item = getItem(index);
+
+    if(item)
+        setWidgetValue(editor, item, index.data(ROLE_VALUE));
+}
+
+void ItemDelegate::setModelData(QWidget* editor, QAbstractItemModel* model,
+                                const QModelIndex& index) const
+{
+    const Global::Item* item = getItem(index);
+
+    if(item)
+        model->setData(index, getWidgetValue(editor, item), ROLE_VALUE);
+}
+
+void ItemDelegate::updateEditorGeometry(QWidget* editor,
+                                        const QStyleOptionViewItem& option,
+                                        const QModelIndex& index) const
+{
+    Q_UNUSED(index);
+
+    editor->setGeometry(option.rect);
+}
+
+bool ItemDelegate::editorEvent(QEvent* event, QAbstractItemModel* model,
+                               const QStyleOptionViewItem& option,
+                               const QModelIndex& index)
+{
+    const Global::Item* item = getItem(index);
+
+    if(!item || item->type != Global::Item::TYPE_BOOL)
+        return QStyledItemDelegate::editorEvent(event, model, option, index);
+
+    // bool items behave like a check box: toggle them on mouse click and on
+    // the space key
+    bool toggle = false;
+
+    if(event->type() == QEvent::MouseButtonRelease)
+    {
+        QMouseEvent* mouse_event = static_cast<QMouseEvent*>(event);
+        toggle = mouse_event->button() == Qt::LeftButton &&
+                option.rect.contains(mouse_event->pos());
+    }
+    else if(event->type() == QEvent::KeyPress)
+    {
+        int key = static_cast<QKeyEvent*>(event)->key();
+        toggle = key == Qt::Key_Space || key == Qt::Key_Select;
+    }
+
+    // items disabled by their conditions are not toggled
+    if(!toggle || !(index.flags() & Qt::ItemIsEnabled))
+        return false;
+
+    return model->setData(
+                index, !index.data(ROLE_VALUE).toBool(), ROLE_VALUE);
+}
+
+/*
+ * write the data of the editor which emitted the signal to the model
+ */
+void ItemDelegate::commitEditor()
+{
+    QWidget* editor = qobject_cast<QWidget*>(QObject::sender());
+
+    if(editor)
+        Q_EMIT commitData(editor);
+}
+
+/*
+ * create the widget used to edit item, without setting its value
+ */
+QWidget* ItemDelegate::createWidget(const Global::Item* item, QWidget* parent)
+{
+    QWidget* new_widget = NULL;
+
+    switch(item->type)
+    {
+    case Global::Item::TYPE_BOOL:
+        new_widget = new QCheckBox(parent);
+        break;
+    case Global::Item::TYPE_TEXT:
+        new_widget = new QLineEdit(parent);
+        break;
+    case Global::Item::TYPE_LIST:
+    {
+        // long lists are filtered by typing instead of scrolling a combo box
+        if(item->list.size() > LIST_SELECTOR_THRESHOLD)
+        {
+            new_widget = new ListSelector(item->list, parent);
+            break;
+        }
+
+        QComboBox* new_combobox = new QComboBox(parent);
+        new_combobox->addItems(item->list);
+        new_widget = new_combobox;
+        break;
+    }
+    case Global::Item::TYPE_FILE:
+    {
+        FileSelector* new_fileselector = new FileSelector(parent);
+        new_fileselector->setDir(item->dir);
+        new_fileselector->setFilter(item->filter);
+        new_fileselector->setFileMustExist(item->mustExist);
+
+        // set file mode
+        const QString& filemode = item->filemode;
+        if(filemode == "file")
+            new_fileselector->setFileMode(FileSelector::FILEMODE_FILE);
+        else if(filemode == "dir")
+            new_fileselector->setFileMode(FileSelector::FILEMODE_DIR);
+        else if(filemode == "both")
+            new_fileselector->setFileMode(FileSelector::FILEMODE_BOTH);
+        else
+        {
+            Global::printText(
+                        stderr,
+                        QObject::tr("[WARNING] Filemode ") + filemode +
+                        QObject::tr(" could not be recognized."));
+        }
+
+        new_widget = new_fileselector;
+        break;
+    }
+    default:
+        break;
+    }
+
+    return new_widget;
+}
+
+/*
+ * display value in a widget created by createWidget
+ */
+void ItemDelegate::setWidgetValue(QWidget* widget, const Global::Item* item,
+                                  const QVariant& value)
+{
+    switch(item->type)
+    {
+    case Global::Item::TYPE_BOOL:
+    {
+        QCheckBox* checkbox = qobject_cast<QCheckBox*>(widget);
+        if(checkbox)
+            checkbox->setChecked(value.toBool());
+        break;
+    }
+    case Global::Item::TYPE_TEXT:
+    {
+        // don't touch the line edit if the text is not changed, otherwise
+        // the cursor would be moved while the user is typing
+        QLineEdit* lineedit = qobject_cast<QLineEdit*>(widget);
+        if(lineedit && lineedit->text() != value.toString())
+            lineedit->setText(value.toString());
+        break;
+    }
+    case Global::Item::TYPE_LIST:
+    {
+        QComboBox* combobox = qobject_cast<QComboBox*>(widget);
+        ListSelector* listselector = qobject_cast<ListSelector*>(widget);
+        if(combobox)
+            combobox->setCurrentIndex(value.toInt());
+        else if(listselector)
+            listselector->setCurrentIndex(value.toInt());
+        break;
+    }
+    case Global::Item::TYPE_FILE:
+    {
+        FileSelector* fileselector = qobject_cast<FileSelector*>(widget);
+        if(fileselector &&
+                fileselector->getLineEdit()->text() != value.toString())
+            fileselector->getLineEdit()->setText(value.toString());
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/*
+ * get the value from a widget created by createWidget
+ */
+QVariant ItemDelegate::getWidgetValue(QWidget* widget,
+                                      const Global::Item* item)
+{
+    switch(item->type)
+    {
+    case Global::Item::TYPE_BOOL:
+    {
+        QCheckBox* checkbox = qobject_cast<QCheckBox*>(widget);
+        if(checkbox)
+            return checkbox->isChecked();
+        break;
+    }
+    case Global::Item::TYPE_TEXT:
+    {
+        QLineEdit* lineedit = qobject_cast<QLineEdit*>(widget);
+        if(lineedit)
+            return lineedit->text();
+        break;
+    }
+    case Global::Item::TYPE_LIST:
+    {
+        QComboBox* combobox = qobject_cast<QComboBox*>(widget);
+        ListSelector* listselector = qobject_cast<ListSelector*>(widget);
+        if(combobox)
+            return combobox->currentIndex();
+        else if(listselector)
+            return listselector->currentIndex();
+        break;
+    }
+    case Global::Item::TYPE_FILE:
+    {
+        FileSelector* fileselector = qobject_cast<FileSelector*>(widget);
+        if(fileselector)
+            return fileselector->getLineEdit()->text();
+        break;
+    }
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+/*
+ * connect the signal emitted when the value of widget is changed to member
+ * of receiver
+ */
+void ItemDelegate::connectWidgetChanged(QWidget* widget,
+                                        const Global::Item* item,
+                                        QObject* receiver, const char* member)
+{
+    switch(item->type)
+    {
+    case Global::Item::TYPE_BOOL:
+        QObject::connect(widget, SIGNAL(toggled(bool)), receiver, member);
+        break;
+    case Global::Item::TYPE_TEXT:
+    case Global::Item::TYPE_FILE:
+        QObject::connect(widget, SIGNAL(textChanged(QString)),
+                         receiver, member);
+        break;
+    case Global::Item::TYPE_LIST:
+        QObject::connect(widget, SIGNAL(currentIndexChanged(int)),
+                         receiver, member);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ITEMDELEGATE_H
+#define ITEMDELEGATE_H
+
+#include <QList>
+#include <QStyledItemDelegate>
+#include <QVariant>
+#include "global.h"
+
+// this class paints the values of the items on a MainTableView without a live
+// widget on each row. An editor is only created while a cell is being edited.
+// The value of an item is stored in the model with the role ROLE_VALUE, and
+// the index of the item in Global::getItems() with the role ROLE_ITEM.
+class ItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    enum // data roles
+    {
+        ROLE_VALUE = Qt::UserRole + 1,
+        ROLE_ITEM
+    };
+
+    // list items with more entries use a ListSelector instead of a combo box
+    static const int LIST_SELECTOR_THRESHOLD = 200;
+
+    ItemDelegate(const QList<Global::Item*>* items, QObject* parent = 0);
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option,
+               const QModelIndex& index) const;
+    QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem& option,
+                          const QModelIndex& index) const;
+    void setEditorData(QWidget* editor, const QModelIndex& index) const;
+    void setModelData(QWidget* editor, QAbstractItemModel* model,
+                      const QModelIndex& index) const;
+    void updateEditorGeometry(QWidget* editor,
+                              const QStyleOptionViewItem& option,
+                              const QModelIndex& index) const;
+
+    // helpers shared with the widget rendering mode
+    static QWidget* createWidget(const Global::Item* item, QWidget* parent);
+    static void setWidgetValue(QWidget* widget, const Global::Item* item,
+                               const QVariant& value);
+    static QVariant getWidgetValue(QWidget* widget, const Global::Item* item);
+    static void connectWidgetChanged(QWidget* widget, const Global::Item* item,
+                                     QObject* receiver, const char* member);
+
+protected:
+    bool editorEvent(QEvent* event, QAbstractItemModel* model,
+                     const QStyleOptionViewItem& option,
+                     const QModelIndex& index);
+
+private:
+    const QList<Global::Item*>* items;
+
+    const Global::Item* getItem(const QModelIndex& index) const;
+
+private Q_SLOTS:
+    void commitEditor();
+};
+
+#endif // ITEMDELEGATE_H
@@ -0,0 +1,253 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "itemvalidator.h"
+#include <QDir>
+#include "fileinfocache.h"
+
+ItemValidator::ItemValidator(Global* global, QObject* parent) :
+    QObject(parent),
+    global(global)
+{
+    debounceTimer.setSingleShot(true);
+    debounceTimer.setInterval(DEBOUNCE_DELAY);
+    connect(&debounceTimer, SIGNAL(timeout()), SLOT(flush()));
+
+    connect(FileInfoCache::getInstance(), SIGNAL(ready(QString)),
+            SLOT(onFileInfoReady(QString)));
+}
+
+/*
+ * check all items with values, indexed by Global::Item::number. Only the
+ * items found invalid are reported by validityChanged().
+ */
+void ItemValidator::setValues(const QVector<QVariant>& values)
+{
+    int count = global->getItems()->count();
+
+    debounceTimer.stop();
+    pendingNumbers.clear();
+    waitingPaths.clear();
+
+    this->values = values;
+    this->values.resize(count);
+    invalid.fill(false, count);
+    waiting.fill(false, count);
+    messages.fill(QString(), count);
+
+    for(int number = 0; number < count; ++number)
+        evaluate(number);
+}
+
+/*
+ * change the value of an item. With debounce, e.g. while the user is typing,
+ * the check is delayed until the value has not changed for a while.
+ */
+void ItemValidator::setValue(int number, const QVariant& value, bool debounce)
+{
+    if(number < 0 || number >= values.count())
+        return;
+
+    values[number] = value;
+
+    if(!global->getItems()->at(number)->hasValidation())
+        return;
+
+    if(!debounce)
+    {
+        evaluate(number);
+        return;
+    }
+
+    if(!pendingNumbers.contains(number))
+        pendingNumbers.append(number);
+    debounceTimer.start();
+}
+
+/*
+ * check the debounced items now
+ */
+void ItemValidator::flush()
+{
+    debounceTimer.stop();
+
+    QVector<int> numbers;
+    numbers.swap(pendingNumbers);
+    Q_FOREACH(int number, numbers)
+        evaluate(number);
+}
+
+/*
+ * whether some results are not known yet
+ */
+bool ItemValidator::isPending() const
+{
+    return !pendingNumbers.isEmpty() || !waitingPaths.isEmpty();
+}
+
+bool ItemValidator::isValid(int number) const
+{
+    return number >= invalid.size() || !invalid.testBit(number);
+}
+
+/*
+ * why the value of an item is invalid, empty if it is valid
+ */
+QString ItemValidator::getMessage(int number) const
+{
+    return messages.value(number);
+}
+
+/*
+ * the number of the first invalid item set in active, -1 if there is none
+ */
+int ItemValidator::getFirstInvalid(const QBitArray* active) const
+{
+    QBitArray bits(invalid);
+    if(active && active->size() == bits.size())
+        bits &= *active;
+
+    if(bits.count(true) == 0)
+        return -1;
+
+    for(int number = 0; number < bits.size(); ++number)
+        if(bits.testBit(number))
+            return number;
+
+    return -1;
+}
+
+/*
+ * check the value of an item. When the file info of its path is not known
+ * yet, the item keeps its result until the info is ready.
+ */
+void ItemValidator::evaluate(int number)
+{
+    const Global::Item* item = global->getItems()->at(number);
+
+    waiting.clearBit(number);
+    if(!item->hasValidation())
+        return;
+
+    // an empty value is only checked by "mustnotempty"
+    QString text(values.at(number).toString());
+    if(text.isEmpty())
+    {
+        setResult(number, QString());
+        return;
+    }
+
+    if(!item->validateRegExp.pattern().isEmpty() &&
+            !item->validateRegExp.match(text).hasMatch())
+    {
+        setResult(number, tr("\"") + text + tr("\" does not match ") +
+                  item->validate);
+        return;
+    }
+
+    if(item->hasMinimum || item->hasMaximum)
+    {
+        bool ok = false;
+        double number_value = text.toDouble(&ok);
+
+        if(!ok)
+        {
+            setResult(number, tr("\"") + text + tr("\" is not a number"));
+            return;
+        }
+        if(item->hasMinimum && number_value < item->minimumValue)
+        {
+            setResult(number, tr("The value must be at least ") +
+                      item->minimum);
+            return;
+        }
+        if(item->hasMaximum && number_value > item->maximumValue)
+        {
+            setResult(number, tr("The value must be at most ") +
+                      item->maximum);
+            return;
+        }
+    }
+
+    if(item->existsMode != Global::Item::EXISTS_NONE)
+    {
+        // relative paths are relative to where the command runs
+        QString path(QDir(*global->getWorkingDir()).absoluteFilePath(text));
+        FileInfoCache* cache = FileInfoCache::getInstance();
+        FileInfoCache::Info info;
+
+        if(!cache->lookup(path, &info))
+        {
+            waiting.setBit(number);
+            if(!waitingPaths.contains(path, number))
+                waitingPaths.insert(path, number);
+            cache->request(path);
+            return;
+        }
+
+        if(!info.exists)
+        {
+            setResult(number, tr("\"") + text + tr("\" does not exist"));
+            return;
+        }
+        if(item->existsMode == Global::Item::EXISTS_FILE && !info.isFile)
+        {
+            setResult(number, tr("\"") + text + tr("\" is not a file"));
+            return;
+        }
+        if(item->existsMode == Global::Item::EXISTS_DIR && !info.isDir)
+        {
+            setResult(number, tr("\"") + text + tr("\" is not a directory"));
+            return;
+        }
+    }
+
+    setResult(number, QString());
+}
+
+/*
+ * store the result of an item, and report it if it has changed
+ */
+void ItemValidator::setResult(int number, const QString& message)
+{
+    if(messages.at(number) == message)
+        return;
+
+    messages[number] = message;
+    invalid.setBit(number, !message.isEmpty());
+
+    Q_EMIT validityChanged(number);
+}
+
+/*
+ * check again the items waiting for the info of path. Items whose value has
+ * changed meanwhile are checked with their new values.
+ */
+void ItemValidator::onFileInfoReady(const QString& path)
+{
+    QList<int> numbers(waitingPaths.values(path));
+    waitingPaths.remove(path);
+
+    Q_FOREACH(int number, numbers)
+        if(number < waiting.size() && waiting.testBit(number))
+            evaluate(number);
+}
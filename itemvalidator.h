@@ -0,0 +1,83 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ITEMVALIDATOR_H
+#define ITEMVALIDATOR_H
+
+#include <QBitArray>
+#include <QMultiHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariant>
+#include <QVector>
+#include "global.h"
+
+// the results of the "validate", "min", "max" and "exists" checks of the
+// items, kept up to date as the values are edited. Typing is debounced, and
+// the existence of files is checked on a worker thread by FileInfoCache, so
+// that running the command only has to look at the invalid bits.
+class ItemValidator : public QObject
+{
+    Q_OBJECT
+public:
+    ItemValidator(Global* global, QObject* parent = 0);
+
+    void setValues(const QVector<QVariant>& values);
+    void setValue(int number, const QVariant& value, bool debounce = false);
+
+    bool isPending() const;
+    bool isValid(int number) const;
+    QString getMessage(int number) const;
+    int getFirstInvalid(const QBitArray* active) const;
+
+Q_SIGNALS:
+    // the result of an item has changed
+    void validityChanged(int number);
+
+public Q_SLOTS:
+    void flush();
+
+private:
+    // delay of the check after a debounced change, in milliseconds
+    static const int DEBOUNCE_DELAY = 300;
+
+    Global* global;
+    QVector<QVariant> values; // indexed by Global::Item::number
+    QBitArray invalid;
+    QVector<QString> messages;
+
+    QVector<int> pendingNumbers;
+    QTimer debounceTimer;
+
+    // the items waiting for the file info of a path
+    QMultiHash<QString, int> waitingPaths;
+    QBitArray waiting;
+
+    void evaluate(int number);
+    void setResult(int number, const QString& message);
+
+private Q_SLOTS:
+    void onFileInfoReady(const QString& path);
+};
+
+#endif // ITEMVALIDATOR_H
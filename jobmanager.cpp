@@ -0,0 +1,230 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jobmanager.h"
+#include <QObject>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// the self-pipe written by the signal handler
+static int childPipe[2] = { -1, -1 };
+static struct sigaction oldChildAction;
+
+/*
+ * the SIGCHLD handler: only wake up the event loop, and let the handler
+ * installed before, e.g. the one of QProcess, see the signal too
+ */
+static void onSigchld(int signum, siginfo_t* info, void* context)
+{
+    int saved_errno = errno;
+    char c = 0;
+    // if the pipe is full, the event loop is already woken up
+    ssize_t written = write(childPipe[1], &c, 1);
+    Q_UNUSED(written);
+    errno = saved_errno;
+
+    if(oldChildAction.sa_flags & SA_SIGINFO)
+    {
+        if(oldChildAction.sa_sigaction)
+            oldChildAction.sa_sigaction(signum, info, context);
+    }
+    else if(oldChildAction.sa_handler != SIG_DFL &&
+            oldChildAction.sa_handler != SIG_IGN)
+        oldChildAction.sa_handler(signum);
+}
+#endif
+
+static JobManager* instance = NULL;
+
+JobManager::JobManager() :
+    notifier(NULL)
+{
+#ifdef Q_OS_UNIX
+    if(pipe(childPipe) != 0)
+        return;
+
+    fcntl(childPipe[0], F_SETFL, fcntl(childPipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl(childPipe[1], F_SETFL, fcntl(childPipe[1], F_GETFL) | O_NONBLOCK);
+    fcntl(childPipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(childPipe[1], F_SETFD, FD_CLOEXEC);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = onSigchld;
+    action.sa_flags = SA_SIGINFO | SA_RESTART | SA_NOCLDSTOP;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGCHLD, &action, &oldChildAction);
+
+    notifier = new QSocketNotifier(childPipe[0], QSocketNotifier::Read, this);
+    connect(notifier, SIGNAL(activated(int)), SLOT(onChildSignal()));
+#endif
+}
+
+/*
+ * the instance lives until the end of the program, since the signal handler
+ * is installed once
+ */
+JobManager* JobManager::getInstance()
+{
+    if(!instance)
+        instance = new JobManager;
+
+    return instance;
+}
+
+/*
+ * start keeping track of a process started by Spawner. If the command runs
+ * in a terminal emulator, pid is the one of the terminal, whose name is
+ * given by terminal. Returns the id of the job.
+ */
+int JobManager::addJob(qint64 pid, const QString& command,
+                       const QString& terminal)
+{
+    Job job;
+    job.pid = pid;
+    job.command = command;
+    job.terminal = terminal;
+    job.startTime = QDateTime::currentDateTime();
+    job.timer.start();
+    job.state = Job::STATE_RUNNING;
+    job.exitCode = 0;
+    job.wallTime = 0;
+    job.userTime = 0;
+    job.systemTime = 0;
+    job.maxRss = 0;
+#ifndef Q_OS_UNIX
+    // the process is not a child which could be waited for
+    job.state = Job::STATE_UNKNOWN;
+#endif
+    jobs.append(job);
+
+    // the child may have exited before it was added
+    int id = jobs.count() - 1;
+    reap(id);
+
+    return id;
+}
+
+const JobManager::Job* JobManager::getJob(int id)
+{
+    if(id < 0 || id >= jobs.count())
+        return NULL;
+
+    return &jobs.at(id);
+}
+
+/*
+ * the wall time of a job so far, in milliseconds
+ */
+qint64 JobManager::getElapsed(int id)
+{
+    const Job& job = jobs.at(id);
+
+    return job.state == Job::STATE_RUNNING ? job.timer.elapsed() :
+        job.wallTime;
+}
+
+void JobManager::onChildSignal()
+{
+#ifdef Q_OS_UNIX
+    char buf[64];
+    while(read(childPipe[0], buf, sizeof(buf)) > 0)
+        ;
+#endif
+
+    for(int i = 0; i < jobs.count(); ++i)
+        reap(i);
+}
+
+/*
+ * wait for a job without blocking, and record its resource usage if it has
+ * ended
+ */
+void JobManager::reap(int id)
+{
+    Job& job = jobs[id];
+
+    if(job.state != Job::STATE_RUNNING)
+        return;
+
+#ifdef Q_OS_UNIX
+    int status = 0;
+    struct rusage usage;
+    pid_t ret = wait4(pid_t(job.pid), &status, WNOHANG, &usage);
+
+    if(ret == 0 || (ret < 0 && errno == EINTR))
+        return;
+
+    job.wallTime = job.timer.elapsed();
+    if(ret < 0)
+        job.state = Job::STATE_UNKNOWN;
+    else
+    {
+        if(WIFSIGNALED(status))
+        {
+            job.state = Job::STATE_SIGNALED;
+            job.exitCode = WTERMSIG(status);
+        }
+        else
+        {
+            job.state = Job::STATE_EXITED;
+            job.exitCode = WEXITSTATUS(status);
+        }
+        job.userTime = usage.ru_utime.tv_sec +
+            usage.ru_utime.tv_usec / 1000000.0;
+        job.systemTime = usage.ru_stime.tv_sec +
+            usage.ru_stime.tv_usec / 1000000.0;
+        // ru_maxrss is in bytes on Mac OS X and in KiB elsewhere
+#ifdef Q_OS_MAC
+        job.maxRss = usage.ru_maxrss / 1024;
+#else
+        job.maxRss = usage.ru_maxrss;
+#endif
+    }
+
+    Q_EMIT jobFinished(id);
+#endif
+}
+
+QString JobManager::stateToString(enum JobManager::Job::State state)
+{
+    switch(state)
+    {
+    case Job::STATE_RUNNING:
+        return QObject::tr("running");
+    case Job::STATE_EXITED:
+        return QObject::tr("exited");
+    case Job::STATE_SIGNALED:
+        return QObject::tr("killed");
+    default:
+        return QObject::tr("unknown");
+    }
+}
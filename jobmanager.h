@@ -0,0 +1,91 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOBMANAGER_H
+#define JOBMANAGER_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QSocketNotifier>
+#include <QString>
+
+// keeps track of the commands started by Spawner. The children are reaped
+// when SIGCHLD arrives, through a self-pipe watched by a QSocketNotifier, and
+// their resource usage is read with wait4(). Only the pids added here are
+// waited for, so that the children of QProcess are left alone.
+class JobManager : public QObject
+{
+    Q_OBJECT
+public:
+    struct Job
+    {
+        enum State
+        {
+            STATE_RUNNING = 0,
+            STATE_EXITED,
+            STATE_SIGNALED,
+            STATE_UNKNOWN // the process could not be waited for
+        };
+
+        qint64 pid;
+        QString command;
+        // the terminal emulator the command runs in, empty if none. The pid,
+        // the exit code and the resource usage are then the terminal's.
+        QString terminal;
+        QDateTime startTime;
+        QElapsedTimer timer;
+        enum State state;
+        int exitCode; // the exit code, or the signal number if signaled
+        qint64 wallTime; // in milliseconds, set when the job ends
+        double userTime; // in seconds
+        double systemTime; // in seconds
+        qint64 maxRss; // in KiB
+    };
+
+    static JobManager* getInstance();
+
+    int addJob(qint64 pid, const QString& command,
+               const QString& terminal = QString());
+    const JobManager::Job* getJob(int id);
+    qint64 getElapsed(int id);
+
+    static QString stateToString(enum JobManager::Job::State state);
+
+Q_SIGNALS:
+    // emitted when a job ends
+    void jobFinished(int id);
+
+private Q_SLOTS:
+    void onChildSignal();
+
+private:
+    JobManager();
+
+    QList<JobManager::Job> jobs;
+    QSocketNotifier* notifier;
+
+    void reap(int id);
+};
+
+#endif // JOBMANAGER_H
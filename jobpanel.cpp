@@ -0,0 +1,224 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "jobpanel.h"
+#include <QFile>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QStringList>
+#include <QTextStream>
+#include <QVBoxLayout>
+#include "jobmanager.h"
+
+JobPanel::JobPanel(QWidget* parent) :
+    QWidget(parent)
+{
+    jobTable = new QTableWidget(0, COLUMN_COUNT, this);
+    jobTable->setHorizontalHeaderLabels(
+                QStringList() << QObject::tr("PID") << QObject::tr("State")
+                << QObject::tr("Wall time") << QObject::tr("User CPU")
+                << QObject::tr("System CPU") << QObject::tr("Max RSS")
+                << QObject::tr("Command"));
+    jobTable->horizontalHeader()->setStretchLastSection(true);
+    jobTable->verticalHeader()->hide();
+    jobTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    jobTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    QPushButton* tmpbutton = new QPushButton(QObject::tr("Export CSV..."),
+                                             this);
+    connect(tmpbutton, SIGNAL(clicked()), SLOT(onClickedButtonExport()));
+
+    QHBoxLayout* tmphbox = new QHBoxLayout();
+    tmphbox->addStretch();
+    tmphbox->addWidget(tmpbutton);
+
+    QVBoxLayout* root_layout = new QVBoxLayout(this);
+    root_layout->setContentsMargins(0, 0, 0, 0);
+    root_layout->addWidget(jobTable);
+    root_layout->addLayout(tmphbox);
+    setLayout(root_layout);
+
+    updateTimer = new QTimer(this);
+    updateTimer->setInterval(UPDATE_INTERVAL);
+    connect(updateTimer, SIGNAL(timeout()), SLOT(updateRunningJobs()));
+
+    connect(JobManager::getInstance(), SIGNAL(jobFinished(int)),
+            SLOT(onJobFinished(int)));
+}
+
+/*
+ * show a job, given by its JobManager id
+ */
+void JobPanel::addJob(int id)
+{
+    int row = jobTable->rowCount();
+
+    jobTable->insertRow(row);
+    for(int column = 0; column < COLUMN_COUNT; ++column)
+        jobTable->setItem(row, column, new QTableWidgetItem());
+
+    // the job may already have ended, updateRow() shows it either way
+    jobIds.append(id);
+    updateRow(row);
+    jobTable->scrollToBottom();
+
+    if(!updateTimer->isActive())
+        updateTimer->start();
+}
+
+void JobPanel::updateRow(int row)
+{
+    JobManager* manager = JobManager::getInstance();
+    const JobManager::Job* job = manager->getJob(jobIds.at(row));
+
+    if(!job)
+        return;
+
+    QString state(JobManager::stateToString(job->state));
+    if(job->state == JobManager::Job::STATE_EXITED ||
+            job->state == JobManager::Job::STATE_SIGNALED)
+        state += " (" + QString::number(job->exitCode) + ")";
+    // the resource usage of a terminal is not the one of the command, so it
+    // is not shown, and the state is labelled as the terminal's
+    if(!job->terminal.isEmpty())
+        state += QObject::tr(" in ") + job->terminal;
+    bool ended = job->state != JobManager::Job::STATE_RUNNING &&
+        job->state != JobManager::Job::STATE_UNKNOWN &&
+        job->terminal.isEmpty();
+
+    jobTable->item(row, COLUMN_PID)->setText(QString::number(job->pid));
+    jobTable->item(row, COLUMN_STATE)->setText(state);
+    jobTable->item(row, COLUMN_WALL_TIME)->setText(
+                QString::number(manager->getElapsed(jobIds.at(row)) / 1000.0,
+                                'f', 1) + " s");
+    jobTable->item(row, COLUMN_USER_TIME)->setText(
+                ended ? QString::number(job->userTime, 'f', 2) + " s" :
+                QString());
+    jobTable->item(row, COLUMN_SYSTEM_TIME)->setText(
+                ended ? QString::number(job->systemTime, 'f', 2) + " s" :
+                QString());
+    jobTable->item(row, COLUMN_MAX_RSS)->setText(
+                ended ? QString::number(job->maxRss) + " KiB" : QString());
+    jobTable->item(row, COLUMN_COMMAND)->setText(job->command);
+    jobTable->item(row, COLUMN_COMMAND)->setToolTip(job->command);
+}
+
+void JobPanel::onJobFinished(int id)
+{
+    int row = jobIds.indexOf(id);
+
+    if(row >= 0)
+        updateRow(row);
+}
+
+/*
+ * update the elapsed time of the running jobs, and stop the timer once none
+ * is running
+ */
+void JobPanel::updateRunningJobs()
+{
+    bool running = false;
+
+    for(int row = 0; row < jobIds.count(); ++row)
+    {
+        const JobManager::Job* job =
+            JobManager::getInstance()->getJob(jobIds.at(row));
+
+        if(job && job->state == JobManager::Job::STATE_RUNNING)
+        {
+            updateRow(row);
+            running = true;
+        }
+    }
+
+    if(!running)
+        updateTimer->stop();
+}
+
+static QString csvField(const QString& field)
+{
+    if(!field.contains(',') && !field.contains('"') &&
+            !field.contains('\n'))
+        return field;
+
+    return '"' + QString(field).replace("\"", "\"\"") + '"';
+}
+
+/*
+ * write the jobs as CSV, times in seconds and memory in KiB. For the jobs
+ * run in a terminal, the pid, the state and the times are the terminal's.
+ */
+bool JobPanel::exportCsv(const QString& file)
+{
+    QFile f(file);
+
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    JobManager* manager = JobManager::getInstance();
+    QTextStream out(&f);
+    out << "pid,command,terminal,start_time,state,exit_code,wall_time,"
+        "user_time,system_time,max_rss\n";
+
+    Q_FOREACH(int id, jobIds)
+    {
+        const JobManager::Job* job = manager->getJob(id);
+
+        if(!job)
+            continue;
+
+        out << job->pid << ','
+            << csvField(job->command) << ','
+            << csvField(job->terminal) << ','
+            << job->startTime.toString(Qt::ISODate) << ','
+            << JobManager::stateToString(job->state) << ','
+            << job->exitCode << ','
+            << manager->getElapsed(id) / 1000.0 << ',';
+
+        // the resource usage of a terminal is left empty
+        if(job->terminal.isEmpty())
+            out << job->userTime << ','
+                << job->systemTime << ','
+                << job->maxRss << '\n';
+        else
+            out << ",,\n";
+    }
+
+    return out.status() == QTextStream::Ok;
+}
+
+void JobPanel::onClickedButtonExport()
+{
+    QString file(QFileDialog::getSaveFileName(
+                     this, QObject::tr("Export the jobs"), QString(),
+                     QObject::tr("CSV files (*.csv)")));
+
+    if(file.isEmpty())
+        return;
+
+    if(!exportCsv(file))
+        QMessageBox::warning(this, QObject::tr("CmdLauncher"),
+                             QObject::tr("Unable to write ") + file);
+}
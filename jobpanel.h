@@ -0,0 +1,71 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOBPANEL_H
+#define JOBPANEL_H
+
+#include <QList>
+#include <QTableWidget>
+#include <QTimer>
+#include <QWidget>
+
+// lists the jobs started from a main window, with their resource usage
+// given by JobManager. The list could be exported as CSV.
+class JobPanel : public QWidget
+{
+    Q_OBJECT
+public:
+    // interval between two updates of the elapsed time, in milliseconds
+    static const int UPDATE_INTERVAL = 1000;
+
+    JobPanel(QWidget* parent = NULL);
+
+    void addJob(int id);
+    bool exportCsv(const QString& file);
+
+private:
+    enum // table columns
+    {
+        COLUMN_PID = 0,
+        COLUMN_STATE,
+        COLUMN_WALL_TIME,
+        COLUMN_USER_TIME,
+        COLUMN_SYSTEM_TIME,
+        COLUMN_MAX_RSS,
+        COLUMN_COMMAND,
+        COLUMN_COUNT
+    };
+
+    QTableWidget* jobTable;
+    QTimer* updateTimer;
+    // the JobManager ids of the jobs on each row
+    QList<int> jobIds;
+
+    void updateRow(int row);
+
+private Q_SLOTS:
+    void onJobFinished(int id);
+    void updateRunningJobs();
+    void onClickedButtonExport();
+};
+
+#endif // JOBPANEL_H
@@ -0,0 +1,215 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "launcherdaemon.h"
+#include <QDataStream>
+#include <QDir>
+#include <QList>
+#include <QtEndian>
+#include "mainwindow.h"
+
+// how long a client waits for the daemon, in milliseconds
+static const int CLIENT_TIMEOUT = 1000;
+
+LauncherDaemon::LauncherDaemon(QObject* parent) :
+    QObject(parent)
+{
+    server = new QLocalServer(this);
+    connect(server, SIGNAL(newConnection()), SLOT(onNewConnection()));
+}
+
+LauncherDaemon::~LauncherDaemon()
+{
+    // the windows own nothing, their instances are deleted here
+    QList<Global*> globals(loaded.values() + windows.values());
+    globals = globals.toSet().toList();
+    qDeleteAll(globals);
+}
+
+/*
+ * the name of the local socket, one per user
+ */
+QString LauncherDaemon::getServerName()
+{
+    QString user(QString::fromLocal8Bit(qgetenv("USER")));
+
+    if(user.isEmpty())
+        user = QString::fromLocal8Bit(qgetenv("USERNAME"));
+
+    return "cmdlauncher-" + user;
+}
+
+/*
+ * start listening for clients. Returns false if another daemon is running or
+ * the socket could not be created.
+ */
+bool LauncherDaemon::listen()
+{
+    QLocalSocket probe;
+    probe.connectToServer(getServerName());
+    if(probe.waitForConnected(CLIENT_TIMEOUT))
+    {
+        Global::printText(stderr, QObject::tr(
+                    "Another daemon is already running"));
+        return false;
+    }
+
+    // remove the socket left by a daemon which did not exit cleanly
+    QLocalServer::removeServer(getServerName());
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    if(!server->listen(getServerName()))
+    {
+        Global::printText(stderr, server->errorString());
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * send the arguments and the current directory to a running daemon. Returns
+ * false if there is no daemon, in which case the caller shows the window
+ * itself.
+ */
+bool LauncherDaemon::sendArguments(const QStringList& arguments)
+{
+    QLocalSocket socket;
+    socket.connectToServer(getServerName());
+    if(!socket.waitForConnected(CLIENT_TIMEOUT))
+        return false;
+
+    // a request is its size followed by the current directory and the
+    // arguments
+    QByteArray request;
+    QDataStream out(&request, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << quint32(0) << QDir::currentPath() << arguments;
+    out.device()->seek(0);
+    out << quint32(request.size() - sizeof(quint32));
+
+    socket.write(request);
+    if(!socket.waitForBytesWritten(CLIENT_TIMEOUT))
+        return false;
+
+    // the daemon answers once the request is read, before it loads anything
+    char reply = 0;
+    if(!socket.waitForReadyRead(CLIENT_TIMEOUT) ||
+            socket.read(&reply, 1) != 1)
+        return false;
+
+    return reply == 1;
+}
+
+void LauncherDaemon::onNewConnection()
+{
+    QLocalSocket* socket;
+
+    while((socket = server->nextPendingConnection()))
+    {
+        connect(socket, SIGNAL(readyRead()), SLOT(onSocketReadyRead()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+void LauncherDaemon::onSocketReadyRead()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+
+    if(!socket)
+        return;
+
+    // wait until the whole request has arrived
+    QDataStream in(socket);
+    in.setVersion(QDataStream::Qt_5_0);
+    uchar size_data[sizeof(quint32)];
+    if(socket->peek(reinterpret_cast<char*>(size_data),
+                    sizeof(size_data)) < qint64(sizeof(size_data)))
+        return;
+    quint32 size = qFromBigEndian<quint32>(size_data);
+    if(socket->bytesAvailable() < qint64(sizeof(quint32) + size))
+        return;
+
+    QString working_dir;
+    QStringList arguments;
+    in >> size >> working_dir >> arguments;
+
+    socket->disconnect(this);
+    socket->putChar(in.status() == QDataStream::Ok ? 1 : 0);
+    socket->disconnectFromServer();
+
+    if(in.status() == QDataStream::Ok)
+        openWindow(working_dir, arguments);
+}
+
+/*
+ * open a window for the arguments of a client. The items are copied from
+ * the instance loaded before for the same cla file, unless it has been
+ * modified since.
+ */
+void LauncherDaemon::openWindow(const QString& working_dir,
+                                const QStringList& arguments)
+{
+    // relative paths in the arguments are relative to the client
+    QDir::setCurrent(working_dir);
+
+    Global* global = new Global(arguments, &loaded);
+    if(global->hasFailed())
+    {
+        delete global;
+        return;
+    }
+
+    // keep the newest instance of each cla file for the next windows
+    Global* old = loaded.value(*global->getConfFile(), NULL);
+    loaded.insert(*global->getConfFile(), global);
+    if(old && old != global)
+        release(old);
+
+    MainWindow* w = new MainWindow(global);
+    w->setAttribute(Qt::WA_DeleteOnClose);
+    windows.insert(w, global);
+    connect(w, SIGNAL(destroyed(QObject*)),
+            SLOT(onWindowDestroyed(QObject*)));
+    w->show();
+    w->raise();
+    w->activateWindow();
+}
+
+void LauncherDaemon::onWindowDestroyed(QObject* window)
+{
+    Global* global = windows.take(window);
+
+    if(global)
+        release(global);
+}
+
+/*
+ * delete an instance if neither a window nor the loaded list uses it
+ */
+void LauncherDaemon::release(Global* global)
+{
+    if(windows.key(global, NULL) ||
+            loaded.value(*global->getConfFile(), NULL) == global)
+        return;
+
+    delete global;
+}
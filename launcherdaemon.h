@@ -0,0 +1,69 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LAUNCHERDAEMON_H
+#define LAUNCHERDAEMON_H
+
+#include <QHash>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QStringList>
+#include "global.h"
+
+class MainWindow;
+
+// a resident cmdlauncher started with --daemon. Later invocations hand their
+// arguments over a local socket to the daemon, which opens the window from
+// the cla files it has already loaded, and exit at once. The catalog window
+// also opens its windows with it, without listening.
+class LauncherDaemon : public QObject
+{
+    Q_OBJECT
+public:
+    LauncherDaemon(QObject* parent = 0);
+    ~LauncherDaemon();
+
+    bool listen();
+    void openWindow(const QString& working_dir,
+                    const QStringList& arguments);
+
+    static QString getServerName();
+    static bool sendArguments(const QStringList& arguments);
+
+private:
+    QLocalServer* server;
+
+    // the last instance loaded for each cla file, by absolute path
+    QHash<QString, Global*> loaded;
+    // the instance used by each open window
+    QHash<QObject*, Global*> windows;
+
+    void release(Global* global);
+
+private Q_SLOTS:
+    void onNewConnection();
+    void onSocketReadyRead();
+    void onWindowDestroyed(QObject* window);
+};
+
+#endif // LAUNCHERDAEMON_H
@@ -0,0 +1,286 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "listcommandcache.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTimer>
+#include "global.h"
+
+// bump CACHE_VERSION whenever the layout of the cache changes
+static const quint32 CACHE_MAGIC = 0x434c414c; // "CLAL"
+static const quint32 CACHE_VERSION = 1;
+
+static ListCommandCache* instance = NULL;
+
+ListCommandCache::ListCommandCache()
+{
+}
+
+/*
+ * the instance lives until the end of the program, since commands may still
+ * be running when it is no longer used
+ */
+ListCommandCache* ListCommandCache::getInstance()
+{
+    if(!instance)
+        instance = new ListCommandCache;
+
+    return instance;
+}
+
+/*
+ * get the entries of the last run of command in working_dir, from memory or
+ * from the disk. fresh is set to whether they are younger than TTL. Return
+ * false if the command has never succeeded.
+ */
+bool ListCommandCache::lookup(const QString& command,
+                              const QString& working_dir,
+                              QStringList* entries, bool* fresh)
+{
+    QString key(getKey(command, working_dir));
+    QHash<QString, Entry>::const_iterator it = cached.constFind(key);
+
+    if(it == cached.constEnd())
+    {
+        Entry entry;
+        if(!readCache(key, &entry))
+            return false;
+        it = cached.insert(key, entry);
+    }
+
+    if(entries)
+        *entries = it->entries;
+    if(fresh)
+        *fresh = QDateTime::currentMSecsSinceEpoch() - it->time < TTL;
+
+    return true;
+}
+
+/*
+ * run command in working_dir with the shell, ready() or failed() is emitted
+ * when it is done. Nothing is done if the same command is already running.
+ */
+void ListCommandCache::request(const QString& command,
+                               const QString& working_dir)
+{
+    QString key(getKey(command, working_dir));
+
+    if(pending.contains(key))
+        return;
+
+    pending.insert(key);
+
+    QProcess* process = new QProcess(this);
+    process->setWorkingDirectory(working_dir);
+    process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    connect(process, SIGNAL(readyReadStandardOutput()),
+            SLOT(onProcessReadyRead()));
+    connect(process, SIGNAL(finished(int,QProcess::ExitStatus)),
+            SLOT(onProcessFinished(int,QProcess::ExitStatus)));
+    connect(process, SIGNAL(error(QProcess::ProcessError)),
+            SLOT(onProcessError(QProcess::ProcessError)));
+
+    // the command is killed if it takes too long
+    QTimer* timer = new QTimer(process);
+    timer->setSingleShot(true);
+    connect(timer, SIGNAL(timeout()), SLOT(onProcessTimeout()));
+    timer->start(TIMEOUT);
+
+    Request request;
+    request.command = command;
+    request.workingDir = working_dir;
+    running.insert(process, request);
+
+#ifdef Q_OS_WIN
+    process->start("cmd", QStringList() << "/C" << command);
+#else
+    process->start("/bin/sh", QStringList() << "-c" << command);
+#endif
+}
+
+void ListCommandCache::onProcessReadyRead()
+{
+    QProcess* process = qobject_cast<QProcess*>(QObject::sender());
+    QHash<QProcess*, Request>::iterator it = running.find(process);
+
+    if(it == running.end())
+        return;
+
+    it->output += process->readAllStandardOutput();
+    if(it->output.size() > MAX_OUTPUT)
+        finish(process, false, QObject::tr("too much output"));
+}
+
+void ListCommandCache::onProcessFinished(int exit_code,
+                                         QProcess::ExitStatus exit_status)
+{
+    QProcess* process = qobject_cast<QProcess*>(QObject::sender());
+
+    if(exit_status != QProcess::NormalExit)
+        finish(process, false, QObject::tr("crashed"));
+    else if(exit_code != 0)
+        finish(process, false, QObject::tr("exited with code ") +
+               QString::number(exit_code));
+    else
+        finish(process, true, QString());
+}
+
+void ListCommandCache::onProcessError(QProcess::ProcessError error)
+{
+    // the other errors are followed by finished()
+    if(error == QProcess::FailedToStart)
+        finish(qobject_cast<QProcess*>(QObject::sender()), false,
+               QObject::tr("failed to start"));
+}
+
+void ListCommandCache::onProcessTimeout()
+{
+    finish(qobject_cast<QProcess*>(QObject::sender()->parent()), false,
+           QObject::tr("timed out"));
+}
+
+/*
+ * store the entries written by a finished command, or report why it failed.
+ * The process is killed if it is still running.
+ */
+void ListCommandCache::finish(QProcess* process, bool succeeded,
+                              const QString& error)
+{
+    QHash<QProcess*, Request>::iterator it = running.find(process);
+
+    if(it == running.end())
+        return;
+
+    Request request(it.value());
+    running.erase(it);
+
+    QString key(getKey(request.command, request.workingDir));
+    pending.remove(key);
+
+    // a killed process is deleted once it has exited, deleting it while it
+    // is running would wait for it in the GUI thread
+    process->disconnect(this);
+    if(succeeded)
+        request.output += process->readAllStandardOutput();
+    if(process->state() == QProcess::NotRunning)
+        process->deleteLater();
+    else
+    {
+        connect(process, SIGNAL(finished(int,QProcess::ExitStatus)),
+                process, SLOT(deleteLater()));
+        process->kill();
+    }
+
+    if(!succeeded)
+    {
+        Global::printText(stderr, QObject::tr("[WARNING] list-cmd \"") +
+                          request.command + "\" " + error);
+        Q_EMIT failed(request.command, request.workingDir);
+        return;
+    }
+
+    Entry entry;
+    entry.time = QDateTime::currentMSecsSinceEpoch();
+    Q_FOREACH(const QString& line,
+              QString::fromLocal8Bit(request.output).split('\n'))
+    {
+        QString trimmed(line.trimmed());
+        if(!trimmed.isEmpty())
+            entry.entries.append(trimmed);
+    }
+
+    cached.insert(key, entry);
+    if(!writeCache(key, entry))
+        Global::printText(stderr, QObject::tr(
+                    "[WARNING] Unable to write the cache of list-cmd \"") +
+                request.command + "\"");
+
+    Q_EMIT ready(request.command, request.workingDir);
+}
+
+bool ListCommandCache::readCache(const QString& key, Entry* entry)
+{
+    QFile f(getCacheFile(key));
+    if(!f.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    QString cached_key;
+    in >> magic >> version;
+    if(magic != CACHE_MAGIC || version != CACHE_VERSION)
+        return false;
+
+    // the key is checked, in case of a collision of the file names
+    in >> cached_key >> entry->time >> entry->entries;
+
+    return in.status() == QDataStream::Ok && cached_key == key;
+}
+
+bool ListCommandCache::writeCache(const QString& key, const Entry& entry)
+{
+    QString cache_file(getCacheFile(key));
+
+    if(!QDir().mkpath(QFileInfo(cache_file).absolutePath()))
+        return false;
+
+    QSaveFile f(cache_file);
+    if(!f.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << CACHE_MAGIC << CACHE_VERSION << key << entry.time
+        << entry.entries;
+
+    return out.status() == QDataStream::Ok && f.commit();
+}
+
+/*
+ * the output of a command may depend on the directory it runs in, e.g. the
+ * branches of a git repository
+ */
+QString ListCommandCache::getKey(const QString& command,
+                                 const QString& working_dir)
+{
+    return working_dir + QChar('\0') + command;
+}
+
+QString ListCommandCache::getCacheFile(const QString& key)
+{
+    QByteArray hash(QCryptographicHash::hash(
+                        key.toUtf8(), QCryptographicHash::Sha1).toHex());
+
+    return QStandardPaths::writableLocation(
+                QStandardPaths::GenericCacheLocation) +
+            "/cmdlauncher/lists/" + QString::fromLatin1(hash) + ".cll";
+}
@@ -0,0 +1,95 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LISTCOMMANDCACHE_H
+#define LISTCOMMANDCACHE_H
+
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// run the "list-cmd" commands of list items in the background and remember
+// their output, one entry per line, in memory and on disk, so that the
+// entries are available at once the next time while they are refreshed
+class ListCommandCache : public QObject
+{
+    Q_OBJECT
+public:
+    // how long the entries are used without running the command again, in
+    // milliseconds
+    static const qint64 TTL = 3600 * 1000;
+    // a command running longer than this is killed, in milliseconds
+    static const int TIMEOUT = 5000;
+    // a command writing more than this is killed, in bytes
+    static const qint64 MAX_OUTPUT = 16 * 1024 * 1024;
+
+    static ListCommandCache* getInstance();
+
+    bool lookup(const QString& command, const QString& working_dir,
+                QStringList* entries, bool* fresh);
+    void request(const QString& command, const QString& working_dir);
+
+Q_SIGNALS:
+    // emitted when the command has finished and its entries are available
+    // from lookup()
+    void ready(const QString& command, const QString& working_dir);
+    // emitted when the command has failed or timed out
+    void failed(const QString& command, const QString& working_dir);
+
+private Q_SLOTS:
+    void onProcessReadyRead();
+    void onProcessFinished(int exit_code, QProcess::ExitStatus exit_status);
+    void onProcessError(QProcess::ProcessError error);
+    void onProcessTimeout();
+
+private:
+    ListCommandCache();
+
+    struct Entry
+    {
+        QStringList entries;
+        qint64 time; // msecs since epoch when the command was run
+    };
+
+    struct Request
+    {
+        QString command;
+        QString workingDir;
+        QByteArray output;
+    };
+
+    QHash<QString, Entry> cached; // indexed by getKey()
+    QSet<QString> pending; // keys of the running commands
+    QHash<QProcess*, Request> running;
+
+    void finish(QProcess* process, bool succeeded, const QString& error);
+    bool readCache(const QString& key, Entry* entry);
+    bool writeCache(const QString& key, const Entry& entry);
+    static QString getKey(const QString& command,
+                          const QString& working_dir);
+    static QString getCacheFile(const QString& key);
+};
+
+#endif // LISTCOMMANDCACHE_H
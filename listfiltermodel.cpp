@@ -0,0 +1,159 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "listfiltermodel.h"
+#include <QtAlgorithms>
+
+ListFilterModel::ListFilterModel(const QStringList& entries, QObject* parent)
+    : QAbstractListModel(parent),
+      entries(entries),
+      matchCount(entries.size()),
+      fetchedCount(qMin(entries.size(), int(FETCH_BATCH)))
+{
+}
+
+int ListFilterModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : fetchedCount;
+}
+
+QVariant ListFilterModel::data(const QModelIndex& index, int role) const
+{
+    if(!index.isValid() || index.row() >= fetchedCount)
+        return QVariant();
+
+    if(role == Qt::DisplayRole)
+        return entries.at(getSourceIndex(index.row()));
+
+    return QVariant();
+}
+
+bool ListFilterModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && fetchedCount < matchCount;
+}
+
+void ListFilterModel::fetchMore(const QModelIndex& parent)
+{
+    if(parent.isValid())
+        return;
+
+    int count = qMin(matchCount - fetchedCount, int(FETCH_BATCH));
+
+    if(count <= 0)
+        return;
+
+    beginInsertRows(QModelIndex(), fetchedCount, fetchedCount + count - 1);
+    fetchedCount += count;
+    endInsertRows();
+}
+
+/*
+ * show only the entries containing text, case insensitively. If text
+ * extends the previous filter, only the previous matches are searched.
+ */
+void ListFilterModel::setFilter(const QString& text)
+{
+    QString new_filter(text.toLower());
+
+    if(new_filter == filter)
+        return;
+
+    beginResetModel();
+
+    if(lowered.isEmpty() && !entries.isEmpty())
+    {
+        lowered.reserve(entries.size());
+        Q_FOREACH(const QString& entry, entries)
+            lowered.append(entry.toLower());
+    }
+
+    if(new_filter.isEmpty())
+        matches.clear();
+    else
+    {
+        // the candidates are the previous matches if the filter is only
+        // extended, since an entry not containing the old text can't
+        // contain the new one
+        QVector<int> candidates;
+        bool narrowing = !filter.isEmpty() && new_filter.startsWith(filter);
+        if(narrowing)
+            candidates = matches;
+
+        QVector<int> prefixed;
+        QVector<int> contained;
+        int candidate_count = narrowing ? candidates.size() : entries.size();
+        for(int i = 0; i < candidate_count; ++i)
+        {
+            int source = narrowing ? candidates.at(i) : i;
+            int pos = lowered.at(source).indexOf(new_filter);
+
+            if(pos == 0)
+                prefixed.append(source);
+            else if(pos > 0)
+                contained.append(source);
+        }
+
+        // an old prefix match may now only contain the text, so the
+        // contained matches are sorted back into the order of the entries
+        if(narrowing)
+            qSort(contained);
+
+        matches = prefixed;
+        matches += contained;
+    }
+
+    filter = new_filter;
+    matchCount = filter.isEmpty() ? entries.size() : matches.size();
+    fetchedCount = qMin(matchCount, int(FETCH_BATCH));
+
+    endResetModel();
+}
+
+/*
+ * the index in the list of the entry on row
+ */
+int ListFilterModel::getSourceIndex(int row) const
+{
+    return filter.isEmpty() ? row : matches.at(row);
+}
+
+/*
+ * the row of the entry source_index, fetching the rows up to it. Returns -1
+ * if it is filtered out.
+ */
+int ListFilterModel::getRow(int source_index)
+{
+    int row = filter.isEmpty() ? source_index : matches.indexOf(source_index);
+
+    if(row < 0 || row >= matchCount)
+        return -1;
+
+    if(row >= fetchedCount)
+    {
+        beginInsertRows(QModelIndex(), fetchedCount, row);
+        fetchedCount = row + 1;
+        endInsertRows();
+    }
+
+    return row;
+}
@@ -0,0 +1,66 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LISTFILTERMODEL_H
+#define LISTFILTERMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// the entries of a list item which match a filter text, entries starting
+// with the text first, then the entries containing it. The rows are handed
+// to the view in batches through fetchMore(), so that a list of thousands
+// of entries costs nothing until it is scrolled.
+class ListFilterModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    // number of rows added by each fetchMore()
+    static const int FETCH_BATCH = 200;
+
+    ListFilterModel(const QStringList& entries, QObject* parent = 0);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role) const;
+    bool canFetchMore(const QModelIndex& parent) const;
+    void fetchMore(const QModelIndex& parent);
+
+    void setFilter(const QString& text);
+    int getSourceIndex(int row) const;
+    int getRow(int source_index);
+
+private:
+    QStringList entries;
+    // entries in lower case, computed on the first filtering
+    QStringList lowered;
+
+    QString filter;
+    // indexes of the matched entries in the entries list, unused when there
+    // is no filter
+    QVector<int> matches;
+    int matchCount;
+    int fetchedCount;
+};
+
+#endif // LISTFILTERMODEL_H
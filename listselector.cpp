@@ -0,0 +1,195 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "listselector.h"
+#include <QApplication>
+#include <QCoreApplication>
+#include <QDesktopWidget>
+#include <QEvent>
+#include <QHBoxLayout>
+#include <QKeyEvent>
+
+ListSelector::ListSelector(const QStringList& entries, QWidget* parent) :
+    QWidget(parent),
+    entries(entries),
+    current(-1)
+{
+    lineEdit = new QLineEdit(this);
+    popupButton = new QToolButton(this);
+    popupButton->setArrowType(Qt::DownArrow);
+
+    QHBoxLayout* tmplayout = new QHBoxLayout(this);
+    tmplayout->setContentsMargins(0, 0, 0, 0);
+    tmplayout->setSpacing(0);
+    lineEdit->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Ignored);
+    tmplayout->addWidget(lineEdit);
+    tmplayout->addWidget(popupButton);
+    setLayout(tmplayout);
+
+    // the popup and its model are created here but only filled when shown
+    filterModel = new ListFilterModel(entries, this);
+    popupView = new QListView(this);
+    popupView->setWindowFlags(Qt::Popup);
+    popupView->setUniformItemSizes(true);
+    popupView->setModel(filterModel);
+    popupView->installEventFilter(this);
+    lineEdit->installEventFilter(this);
+
+    connect(lineEdit, SIGNAL(textEdited(QString)),
+            SLOT(onTextEdited(QString)));
+    connect(popupButton, SIGNAL(clicked()), SLOT(onPopupButtonClicked()));
+    connect(popupView, SIGNAL(clicked(QModelIndex)),
+            SLOT(onPopupActivated(QModelIndex)));
+    connect(popupView, SIGNAL(activated(QModelIndex)),
+            SLOT(onPopupActivated(QModelIndex)));
+
+    setFocusProxy(lineEdit);
+    setCurrentIndex(0);
+}
+
+int ListSelector::currentIndex() const
+{
+    return current;
+}
+
+void ListSelector::setCurrentIndex(int index)
+{
+    if(index < 0 || index >= entries.size() || index == current)
+        return;
+
+    current = index;
+    lineEdit->setText(entries.at(index));
+    Q_EMIT currentIndexChanged(index);
+}
+
+void ListSelector::onTextEdited(const QString& text)
+{
+    filterModel->setFilter(text);
+    showPopup();
+    if(filterModel->rowCount() > 0)
+        popupView->setCurrentIndex(filterModel->index(0));
+}
+
+void ListSelector::onPopupButtonClicked()
+{
+    filterModel->setFilter(QString());
+    showPopup();
+    selectRow(filterModel->getRow(current));
+}
+
+void ListSelector::onPopupActivated(const QModelIndex& index)
+{
+    if(!index.isValid())
+        return;
+
+    int source = filterModel->getSourceIndex(index.row());
+    hidePopup();
+    setCurrentIndex(source);
+    // show the entry again even if it is already the current one
+    lineEdit->setText(entries.at(current));
+    lineEdit->selectAll();
+}
+
+void ListSelector::selectRow(int row)
+{
+    if(row < 0)
+        return;
+
+    QModelIndex index(filterModel->index(row));
+    popupView->setCurrentIndex(index);
+    popupView->scrollTo(index, QAbstractItemView::PositionAtCenter);
+}
+
+/*
+ * show the popup below the widget, or above it if there is no room
+ */
+void ListSelector::showPopup()
+{
+    QRect screen(QApplication::desktop()->availableGeometry(this));
+    QPoint pos(mapToGlobal(QPoint(0, height())));
+    int popup_height = qMin(300, screen.height() / 3);
+
+    if(pos.y() + popup_height > screen.bottom())
+        pos.setY(mapToGlobal(QPoint(0, 0)).y() - popup_height);
+
+    popupView->setGeometry(pos.x(), pos.y(), width(), popup_height);
+    if(!popupView->isVisible())
+        popupView->show();
+}
+
+void ListSelector::hidePopup()
+{
+    popupView->hide();
+}
+
+bool ListSelector::eventFilter(QObject* watched, QEvent* event)
+{
+    if(event->type() != QEvent::KeyPress)
+    {
+        // restore the current entry when the user leaves without choosing
+        if(watched == lineEdit && event->type() == QEvent::FocusOut &&
+                !popupView->isVisible() && current >= 0 &&
+                lineEdit->text() != entries.at(current))
+            lineEdit->setText(entries.at(current));
+
+        return QWidget::eventFilter(watched, event);
+    }
+
+    QKeyEvent* key_event = static_cast<QKeyEvent*>(event);
+
+    if(watched == lineEdit)
+    {
+        // open the popup from the line edit
+        if(key_event->key() == Qt::Key_Down && !popupView->isVisible())
+        {
+            onPopupButtonClicked();
+            return true;
+        }
+
+        return QWidget::eventFilter(watched, event);
+    }
+
+    if(watched != popupView)
+        return QWidget::eventFilter(watched, event);
+
+    // the popup grabs the keyboard: navigation keys are handled by the view,
+    // the others are typed into the line edit, like QCompleter does
+    switch(key_event->key())
+    {
+    case Qt::Key_Up:
+    case Qt::Key_Down:
+    case Qt::Key_PageUp:
+    case Qt::Key_PageDown:
+        return false;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        onPopupActivated(popupView->currentIndex());
+        return true;
+    case Qt::Key_Escape:
+        hidePopup();
+        lineEdit->setText(entries.value(current));
+        return true;
+    default:
+        QCoreApplication::sendEvent(lineEdit, event);
+        return true;
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LISTSELECTOR_H
+#define LISTSELECTOR_H
+
+#include <QLineEdit>
+#include <QListView>
+#include <QStringList>
+#include <QToolButton>
+#include <QWidget>
+#include "listfiltermodel.h"
+
+// used instead of a QComboBox for list items with many entries. The current
+// entry is shown in a line edit, typing in it filters the entries shown in a
+// popup list. The index of an entry is always its index in the list item, so
+// that "value/n" is not affected by the filter.
+class ListSelector : public QWidget
+{
+    Q_OBJECT
+public:
+    ListSelector(const QStringList& entries, QWidget* parent = 0);
+
+    int currentIndex() const;
+    void setCurrentIndex(int index);
+
+Q_SIGNALS:
+    void currentIndexChanged(int index);
+
+private:
+    QStringList entries;
+    int current;
+
+    QLineEdit* lineEdit;
+    QToolButton* popupButton;
+    QListView* popupView;
+    ListFilterModel* filterModel;
+
+    void showPopup();
+    void hidePopup();
+    void selectRow(int row);
+
+    bool eventFilter(QObject* watched, QEvent* event);
+
+private Q_SLOTS:
+    void onTextEdited(const QString& text);
+    void onPopupButtonClicked();
+    void onPopupActivated(const QModelIndex& index);
+};
+
+#endif // LISTSELECTOR_H
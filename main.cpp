@@ -21,16 +21,274 @@
  */
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QMetaObject>
+#include <QStringList>
+#include <QVector>
+#include <cstdio>
+#include <cstring>
+#include "batchrunner.h"
+#include "catalogwindow.h"
+#include "commandbuilder.h"
 #include "global.h"
+#include "itemconditions.h"
+#include "launcherdaemon.h"
+#include "listcommandcache.h"
 #include "mainwindow.h"
+#include "profiler.h"
+
+/*
+ * fill the "list-cmd" items with the entries cached by the main window. The
+ * commands are not run, items without cached entries keep their "list".
+ */
+static void useCachedLists(Global* g)
+{
+    Q_FOREACH(const Global::Item* item, *g->getItems())
+    {
+        QStringList entries;
+        if(item->type == Global::Item::TYPE_LIST && !item->listCmd.isEmpty() &&
+                ListCommandCache::getInstance()->lookup(
+                    item->listCmd, *g->getWorkingDir(), &entries, NULL))
+            g->setItemList(item->number, entries);
+    }
+}
+
+/*
+ * print the final command assembled from the values given on the command
+ * line, without creating any QApplication or widget
+ */
+static int runHeadless(const QStringList& arguments)
+{
+    Global global(arguments);
+    Global* g = &global;
+    useCachedLists(g);
+    QVector<QVariant> values(CommandBuilder::initialValues(*g->getItems()));
+    QString error;
+
+    // values from --values are read first, so that --value overrides them
+    if(!g->getValuesFile()->isEmpty())
+    {
+        QFile f(*g->getValuesFile());
+        bool opened = *g->getValuesFile() == "-" ?
+                    f.open(stdin, QIODevice::ReadOnly) :
+                    f.open(QIODevice::ReadOnly);
+
+        if(!opened)
+        {
+            Global::printText(stderr, QObject::tr("Unable to read ") +
+                              *g->getValuesFile());
+            return 6;
+        }
+
+        if(!CommandBuilder::readValuesJson(g, f.readAll(), &values, &error))
+        {
+            Global::printText(stderr, error);
+            return 6;
+        }
+    }
+
+    if(!CommandBuilder::readValueArguments(
+                g, *g->getValueArguments(), &values, &error))
+    {
+        Global::printText(stderr, error);
+        return 6;
+    }
+
+    // the items whose conditions are false are left out
+    ItemConditions conditions(g);
+    conditions.setValues(values);
+
+    const Global::Item* empty_item = NULL;
+    if(g->getHeadlessMode() == Global::HEADLESSMODE_PRINT_CMD)
+    {
+        QString final_cmd(CommandBuilder::build(
+                              *g->getCommand(), *g->getItems(), values,
+                              &empty_item, conditions.getActive()));
+
+        if(!empty_item)
+        {
+            QByteArray out(final_cmd.toLocal8Bit());
+            out += '\n';
+            fwrite(out.constData(), 1, out.size(), stdout);
+        }
+    }
+    else
+    {
+        QStringList args(CommandBuilder::buildArguments(
+                             *g->getCommand(), *g->getItems(), values,
+                             &empty_item, conditions.getActive()));
+
+        // keep the terminating NUL of each argument
+        Q_FOREACH(const QString& arg, args)
+        {
+            QByteArray out(arg.toLocal8Bit());
+            fwrite(out.constData(), 1, out.size() + 1, stdout);
+        }
+    }
+
+    Profiler::report();
+
+    if(empty_item)
+    {
+        Global::printText(stderr, QObject::tr("Item \"") + empty_item->key +
+                          QObject::tr("\" must not be empty."));
+        return 7;
+    }
+
+    return 0;
+}
+
+/*
+ * run the command for each record of values, without any widget
+ */
+static int runBatch(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    Global global(a.arguments());
+    Global* g = &global;
+    useCachedLists(g);
+    QFile f(*g->getBatchFile());
+    bool opened = *g->getBatchFile() == "-" ?
+                f.open(stdin, QIODevice::ReadOnly) :
+                f.open(QIODevice::ReadOnly);
+
+    if(!opened)
+    {
+        Global::printText(stderr, QObject::tr("Unable to read ") +
+                          *g->getBatchFile());
+        return 6;
+    }
+
+    BatchRunner runner(g, &f, g->getMaxJobs());
+    QObject::connect(&runner, SIGNAL(finished()), &a, SLOT(quit()));
+    QMetaObject::invokeMethod(&runner, "start", Qt::QueuedConnection);
+    a.exec();
+
+    return runner.getFailedCount() > 0 ? 8 : 0;
+}
+
+/*
+ * stay resident and open a window for each client, see LauncherDaemon
+ */
+static int runDaemon(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    a.setQuitOnLastWindowClosed(false);
+
+    LauncherDaemon daemon;
+    if(!daemon.listen())
+        return 9;
+
+    // the daemon also opens the window of its own cla file, if any
+    QStringList arguments(a.arguments());
+    Q_FOREACH(const QString& arg, arguments.mid(1))
+    {
+        if(arg != "--daemon" && !arg.startsWith("--profile-startup"))
+        {
+            daemon.openWindow(QDir::currentPath(), arguments);
+            break;
+        }
+    }
+
+    return a.exec();
+}
+
+/*
+ * search the cla files under a directory and open the chosen ones
+ */
+static int runCatalog(int argc, char *argv[], int catalog_index)
+{
+    QApplication a(argc, argv);
+
+    // the other arguments are given to the windows opened from the catalog
+    QStringList arguments(a.arguments());
+    QString dir(arguments.value(catalog_index + 1));
+    arguments.erase(arguments.begin() + catalog_index,
+                    arguments.begin() + qMin(catalog_index + 2,
+                                             arguments.size()));
+
+    if(dir.isEmpty() || !QDir(dir).exists())
+    {
+        Global::printText(stderr, QObject::tr("--catalog requires a "
+                                              "directory"));
+        return 1;
+    }
+
+    CatalogWindow w(dir, arguments);
+    w.show();
+
+    return a.exec();
+}
 
 int main(int argc, char *argv[])
 {
+    // the profiler must be enabled before anything else is done
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--profile-startup") == 0)
+            Profiler::enable();
+        else if(strncmp(argv[i], "--profile-startup=", 18) == 0)
+            Profiler::enable(QString::fromLocal8Bit(argv[i] + 18));
+    }
+
+    // the final command could be printed or run without the window, in
+    // which case Qt GUI is not initialized at all
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--print-cmd") == 0 ||
+                strcmp(argv[i], "--print-argv") == 0)
+        {
+            QStringList arguments;
+            for(int j = 0; j < argc; ++j)
+                arguments.append(QString::fromLocal8Bit(argv[j]));
+
+            return runHeadless(arguments);
+        }
+        else if(strcmp(argv[i], "--batch") == 0)
+            return runBatch(argc, argv);
+    }
+
+    bool daemon = false;
+    bool use_daemon = true;
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--catalog") == 0)
+            return runCatalog(argc, argv, i);
+        else if(strcmp(argv[i], "--daemon") == 0)
+            daemon = true;
+        else if(strcmp(argv[i], "--no-daemon") == 0 ||
+                strcmp(argv[i], "--help") == 0)
+            use_daemon = false;
+    }
+
+    if(daemon)
+        return runDaemon(argc, argv);
+
+    // hand the arguments to a running daemon if there is one, which is much
+    // faster than initializing Qt GUI and loading the cla file here. The
+    // socket is only used with blocking calls, so that no application object
+    // is needed before the one of the window.
+    if(use_daemon)
+    {
+        QStringList arguments;
+        for(int i = 0; i < argc; ++i)
+            arguments.append(QString::fromLocal8Bit(argv[i]));
+
+        if(LauncherDaemon::sendArguments(arguments))
+            return 0;
+    }
+
     QApplication a(argc, argv);
+    Profiler::mark("QApplication created");
 
-    Global::getInstance();
+    Global global(a.arguments());
+    Profiler::mark("Global created");
 
-    MainWindow w;
+    MainWindow w(&global);
+    Profiler::mark("MainWindow created");
     w.show();
 
     return a.exec();
@@ -22,8 +22,11 @@
 
 #include "mainwindow.h"
 #include <QApplication>
-#include <QCheckBox>
+#include <QBrush>
 #include <QComboBox>
+#include <QDateTime>
+#include <QDir>
+#include <QHash>
 #include <QHBoxLayout>
 #include <QHeaderView>
 #include <QLabel>
@@ -31,169 +34,203 @@
 #include <QList>
 #include <QMenu>
 #include <QMessageBox>
+#include <QPaintEvent>
 #include <QPixmap>
-#include <QProcess>
 #include <QPushButton>
 #include <QResizeEvent>
+#include <QSet>
+#include <QShowEvent>
+#include <QSignalMapper>
 #include <QStringList>
 #include <QTextStream>
+#include <QTimer>
+#include <QVector>
 #include <QVBoxLayout>
 #include "aboutdialog.h"
-#include "fileselector.h"
+#include "commandbuilder.h"
+#include "commandpreview.h"
+#include "confreloader.h"
+#include "consolewindow.h"
 #include "global.h"
-
-MainWindow::MainWindow(QWidget *parent)
-    : QWidget(parent)
+#include "itemconditions.h"
+#include "itemdelegate.h"
+#include "itemvalidator.h"
+#include "jobmanager.h"
+#include "jobpanel.h"
+#include "listcommandcache.h"
+#include "profiler.h"
+#include "spawner.h"
+#include "terminalfinder.h"
+
+MainWindow::MainWindow(Global* global, QWidget *parent)
+    : QWidget(parent),
+      global(global),
+      history(*global->getConfFile()),
+      conditions(global),
+      searchPosition(0),
+      firstPainted(false),
+      reloading(false),
+      updatingStates(false)
 {
-    setGeometry(*Global::getInstance()->getStartupGeometry());
+    setGeometry(*global->getStartupGeometry());
 
-    setWindowTitle(*Global::getInstance()->getWindowTitle() +
+    setWindowTitle(*global->getWindowTitle() +
                    "  --  " + QObject::tr("CmdLauncher"));
 
 
     this->ui.mainTabWidget = new QTabWidget(this);
 
+    // large cla files are displayed with a delegate instead of a widget on
+    // each row, unless the user asks for a specific render mode
+    const QList<Global::Item*>* all_items = global->getItems();
+    switch(global->getRenderMode())
+    {
+    case Global::RENDERMODE_WIDGETS:
+        useDelegates = false;
+        break;
+    case Global::RENDERMODE_DELEGATES:
+        useDelegates = true;
+        break;
+    default:
+        useDelegates = all_items->count() > DELEGATE_THRESHOLD;
+        break;
+    }
+    itemDelegate = new ItemDelegate(all_items, this);
+    itemWidgetMapper = new QSignalMapper(this);
+    connect(itemWidgetMapper, SIGNAL(mapped(int)),
+            SLOT(onItemWidgetChanged(int)));
+
     // if tabs are specified, then we use the tabs; otherwise we create a tab
     // whose name is "All"
-    QStringList tmpstrlist = *Global::getInstance()->getTabs();
+    QStringList tmpstrlist = *global->getTabs();
     if(tmpstrlist.empty())
         tmpstrlist.append(QObject::tr("All"));
     Q_FOREACH(const QString& tab, tmpstrlist)
-    {
-        QStandardItemModel* tmpmodel = createTableModel();
-        MainTableView*      tmpview = createTableView();
-        tmpview->setModel(tmpmodel);
-        this->ui.mainTableViews.append(tmpview);
-        this->model.mainTableModels.append(tmpmodel);
-        QWidget* tmpwidget = new QWidget(this->ui.mainTabWidget);
-        QVBoxLayout* tmpvboxlayout = new QVBoxLayout();
-        tmpvboxlayout->addWidget(tmpview);
-        tmpwidget->setLayout(tmpvboxlayout);
-        this->ui.mainTabWidget->addTab(tmpwidget, tab);
-
-        connect(tmpview, SIGNAL(sizeChanged(QSize,QSize)),
-                SLOT(onMainTableViewsSizeChanged(QSize,QSize)));
-    }
+        addTab(tab);
 
     // read data and display
-    QList<Global::Item*>* items0 = new QList<Global::Item*>(
-                *Global::getInstance()->getItems());
-
-    qSort(items0->begin(), items0->end(), Global::lessThanItemsDisplayorder);
-
-    const QList<Global::Item*>* items = items0;
-
-    int count = items->count();
-
-    for(int i = 0; i < count; ++ i)
+    QList<QList<const Global::Item*> > items_of_tabs(getItemsOfTabs());
+    for(int tabpage = 0; tabpage < items_of_tabs.count(); ++tabpage)
     {
-        const Global::Item* item = items->at(i);
-        int tabpage = Global::getInstance()->getTabs()->indexOf(
-                    item->value("tab").toString());
-
-        if(tabpage < 0)
-            tabpage = 0;
-
-        Global::getInstance()->setItemTabpageRow(
-                    item->value("No.").toInt(),
-                    tabpage, model.mainTableModels[tabpage]->rowCount());
-
-        model.mainTableModels[tabpage]->appendRow(
-                new QStandardItem(item->value("title", "").toString()));
-
-        const QString type_string = item->value("type").toString();
-
-        QWidget* new_widget = NULL;
-
-        if(type_string == "bool")
-        {
-            QCheckBox* new_checkbox = new QCheckBox();
-            new_checkbox->setCheckState(
-                        item->value("default", false).toBool() ?
-                        Qt::Checked : Qt::Unchecked);
-            new_widget = new_checkbox;
-        }
-        else if(type_string == "text")
-        {
-            QLineEdit* new_lineedit =
-                    new QLineEdit(item->value("default", "").toString());
-            new_widget = new_lineedit;
-        }
-        else if(type_string == "list")
+        Q_FOREACH(const Global::Item* item, items_of_tabs.at(tabpage))
         {
-            QComboBox* new_combobox =
-                    new QComboBox(ui.mainTableViews[tabpage]);
-            new_combobox->addItems(item->value("list").toString().split(','));
-            new_combobox->setCurrentIndex(item->value("default").toInt());
-            new_widget = new_combobox;
+            global->setItemTabpageRow(
+                        item->number,
+                        tabpage, model.mainTableModels[tabpage]->rowCount());
+
+            // the value of the item lives in the model, the editors are only
+            // views of it
+            model.mainTableModels[tabpage]->appendRow(
+                        createRow(item, item->initialValue()));
+
+            // in the widget render mode, the editors are created when the tab
+            // is built
+            model.itemsOfTabs[tabpage].append(item);
         }
-        else if(type_string == "file")
-        {
-            FileSelector* new_fileselector =
-                    new FileSelector(ui.mainTableViews[tabpage]);
-            new_fileselector->getLineEdit()->setText(
-                        item->value("default").toString());
-            new_fileselector->setDir(item->value("dir").toString());
-            new_fileselector->setFilter(item->value("filter").toString());
-            new_fileselector->setFileMustExist(
-                        item->value("mustexist", true).toBool());
-
-            // set file mode
-            QString filemode = item->value("filemode", "file").toString();
-            if(filemode == "file")
-                new_fileselector->setFileMode(FileSelector::FILEMODE_FILE);
-            else if(filemode == "dir")
-                new_fileselector->setFileMode(FileSelector::FILEMODE_DIR);
-            else if(filemode == "both")
-                new_fileselector->setFileMode(FileSelector::FILEMODE_BOTH);
-            else
-            {
-                Global::printText(
-                            stderr,
-                            QObject::tr("[WARNING] Filemode ") + filemode +
-                            QObject::tr(" could not be recognized."));
-            }
-
-            new_widget = new_fileselector;
-        }
-
-        if(new_widget)
-            ui.mainTableViews[tabpage]->setIndexWidget(
-                        model.mainTableModels[tabpage]->index(
-                            model.mainTableModels[tabpage]->rowCount() - 1,
-                            COLUMN_VALUE),
-                        new_widget);
     }
 
-    delete items0;
-
     // put a "n items" on the bottom of each tab.
-    int tabcount = ui.mainTabWidget->count();
-    for(int i = 0; i < tabcount; ++i)
-        ui.mainTabWidget->widget(i)->layout()->addWidget(
-                    new QLabel(QString::number(
-                                   model.mainTableModels[i]->rowCount())
-                               + QObject::tr(" item(s).")));
+    updateItemCountLabels();
+
+    // the items whose conditions are false are disabled or hidden
+    conditions.setValues(getItemValues());
+    Q_FOREACH(int number, *global->getConditionOrder())
+        applyItemState(all_items->at(number));
+
+    // the values are checked as they are edited, the invalid items are
+    // marked on their rows
+    validator = new ItemValidator(global, this);
+    connect(validator, SIGNAL(validityChanged(int)),
+            SLOT(onItemValidityChanged(int)));
+    validator->setValues(getItemValues());
 
     // initialize the terminal combobox
-    ui.termCombobox = new QComboBox(this);
-    Q_FOREACH(const Global::Terminal* term,
-              *Global::getInstance()->getTerminals())
     {
-        ui.termCombobox->addItem(term->name);
+        ProfileScope profile("terminal combobox setup");
+        ui.termCombobox = new QComboBox(this);
+
+        // the terminals not known yet are searched for in the background,
+        // the combobox is filled again when they are found
+        TerminalFinder* finder = TerminalFinder::getInstance();
+        QStringList programs;
+        Q_FOREACH(const Global::Terminal* term, *global->getTerminals())
+            programs.append(TerminalFinder::getProgram(term));
+        termChosen = false;
+        connect(ui.termCombobox, SIGNAL(activated(int)),
+                SLOT(onTermComboboxActivated()));
+        if(!finder->lookup(programs, NULL))
+        {
+            connect(finder, SIGNAL(ready()), SLOT(fillTermCombobox()));
+            finder->find(programs);
+        }
+        fillTermCombobox();
     }
 
+    // the preview of the final command, updated when the values in the
+    // models are changed
+    ui.commandPreview = new CommandPreview(
+                *global->getCommand(), all_items, this);
+    ui.commandPreview->setActive(conditions.getActive());
+    ui.commandPreview->setValues(getItemValues());
+
+    // the entries of "list-cmd" items are filled when their commands have
+    // finished, the window does not wait for them
+    ListCommandCache* list_cache = ListCommandCache::getInstance();
+    connect(list_cache, SIGNAL(ready(QString,QString)),
+            SLOT(onListCommandReady(QString,QString)));
+    connect(list_cache, SIGNAL(failed(QString,QString)),
+            SLOT(onListCommandFailed(QString,QString)));
+    Q_FOREACH(const Global::Item* item, *all_items)
+        setupDynamicList(item);
+
+    // only the editors on the visible tab are created now. The other tabs are
+    // built when they are activated, or when the application becomes idle
+    // after the window is shown.
+    buildTab(ui.mainTabWidget->currentIndex());
+    connect(ui.mainTabWidget, SIGNAL(currentChanged(int)),
+            SLOT(buildTab(int)));
+
+    // the items of all tabs are searched with the index built by Global
+    ui.searchLineEdit = new QLineEdit(this);
+    ui.searchLineEdit->setPlaceholderText(QObject::tr("Search items"));
+    ui.searchResultLabel = new QLabel(this);
+    connect(ui.searchLineEdit, SIGNAL(textChanged(QString)),
+            SLOT(onSearchTextChanged()));
+    connect(ui.searchLineEdit, SIGNAL(returnPressed()),
+            SLOT(onSearchReturnPressed()));
+
     // layout
     QVBoxLayout* root_layout = new QVBoxLayout(this);
 
+    QHBoxLayout* search_layout = new QHBoxLayout();
+    search_layout->addWidget(ui.searchLineEdit);
+    search_layout->addWidget(ui.searchResultLabel);
+    root_layout->addLayout(search_layout);
     root_layout->addWidget(ui.mainTabWidget);
+    root_layout->addWidget(ui.commandPreview);
+
+    // the runs started from this window, shown after the first one
+    ui.jobPanel = new JobPanel(this);
+    ui.jobPanel->hide();
+    root_layout->addWidget(ui.jobPanel);
 
 
     QHBoxLayout* tmphbox = new QHBoxLayout();
     tmphbox->addStretch();
 
+    // the values of the previous runs, read when the menu is shown
+    QMenu* history_menu = new QMenu(this);
+    connect(history_menu, SIGNAL(aboutToShow()),
+            SLOT(onHistoryMenuAboutToShow()));
+    connect(history_menu, SIGNAL(triggered(QAction*)),
+            SLOT(onHistoryMenuTriggered(QAction*)));
+    QPushButton* tmpbutton = new QPushButton(QObject::tr("History"), this);
+    tmpbutton->setMenu(history_menu);
+    tmphbox->addWidget(tmpbutton, 0, Qt::AlignRight);
+    history.compactIfNeeded();
+
     tmphbox->addWidget(ui.termCombobox, 0, Qt::AlignRight);
-    QPushButton* tmpbutton = new QPushButton(QObject::tr("Run"), this);
+    tmpbutton = new QPushButton(QObject::tr("Run"), this);
     this->connect(tmpbutton, SIGNAL(clicked()), SLOT(onClickedButtonStart()));
     tmphbox->addWidget(tmpbutton, 0, Qt::AlignRight);
 
@@ -205,133 +242,868 @@ MainWindow::MainWindow(QWidget *parent)
 
 
     setLayout(root_layout);
+
+    // the changes of the cla file are applied while it is being edited
+    confReloader = new ConfReloader(*global->getConfFile(),
+                                    global->getUseCache(), this);
+    connect(confReloader, SIGNAL(reloaded()), SLOT(onConfReloaded()));
 }
 
 MainWindow::~MainWindow()
 {
 }
 
-void MainWindow::onClickedButtonStart()
+void MainWindow::paintEvent(QPaintEvent* event)
 {
-    // figure out the final command and run it.
-    QString final_cmd(*Global::getInstance()->getCommand());
-    const QList<Global::Item*>* items = Global::getInstance()->getItems();
-    int count = items->count();
+    QWidget::paintEvent(event);
 
-    for(int i = 0; i < count; ++i)
+    // the startup profile ends at the first paint
+    if(Profiler::isEnabled() && !firstPainted)
     {
-        const Global::Item* item = items->at(i);
-        const QString type_string = item->value("type").toString();
-        int tabpage = item->value("tabpage").toInt();
-        int row = item->value("row").toInt();
+        firstPainted = true;
+        Profiler::mark("first paint");
+        Profiler::report();
+    }
+}
 
-        if(type_string == "bool")
-        {
-            // bool type, if set to true, then use "value/yes", otherwise use
-            // "value/no"
+void MainWindow::showEvent(QShowEvent* event)
+{
+    QWidget::showEvent(event);
 
-            QString tmpstr("value/");
-            QCheckBox* widget = qobject_cast<QCheckBox*>(
-                        ui.mainTableViews[tabpage]->indexWidget(
-                            model.mainTableModels[tabpage]->index(
-                                row, COLUMN_VALUE)));
+    // build the remaining tabs after the window is painted
+    QTimer::singleShot(0, this, SLOT(buildNextTab()));
+}
 
-            tmpstr += (widget->isChecked() ? "yes" : "no");
+/*
+ * create the editor widgets of all items on the tab, if they have not been
+ * created yet
+ */
+void MainWindow::buildTab(int tabpage)
+{
+    if(tabpage < 0 || tabpage >= model.tabsBuilt.count() ||
+            model.tabsBuilt[tabpage])
+        return;
 
-            final_cmd += " ";
-            final_cmd += item->value(tmpstr, "").toString();
-        }
-        else if(type_string == "text")
-        {
-            // text type, if it is empty, use "value/empty", otherwise use
-            // "value/nonempty", and replace "%a" with the text in the
-            // lineedit
-
-            QString tmpstr("value/");
-            QLineEdit* widget = qobject_cast<QLineEdit*>(
-                        ui.mainTableViews[tabpage]->indexWidget(
-                            model.mainTableModels[tabpage]->index(
-                                row, COLUMN_VALUE)));
-
-            // if the field must be filled but it's empty, ask the user to
-            // fill it
-            if(item->value("mustnotempty", false).toBool() &&
-                    widget->text().isEmpty())
-            {
-                QMessageBox::information(
-                            this,
-                            QObject::tr(""),
-                            QObject::tr("Some fields must not be empty."));
+    model.tabsBuilt[tabpage] = true;
 
-                selectItemOnMainTableViews(*item);
+    ProfileScope profile("build tab " + QString::number(tabpage));
 
-                return;
-            }
+    Q_FOREACH(const Global::Item* item, model.itemsOfTabs[tabpage])
+        createItemWidget(item);
+}
 
-            tmpstr += widget->text().isEmpty() ? "empty" : "nonempty";
+/*
+ * create the editor widget of an item on its row
+ */
+void MainWindow::createItemWidget(const Global::Item* item)
+{
+    MainTableView* view = ui.mainTableViews[item->tabpage];
+    QModelIndex index = model.mainTableModels[item->tabpage]->index(
+                item->row, COLUMN_VALUE);
+    QWidget* new_widget = ItemDelegate::createWidget(item, view);
 
-            final_cmd += " ";
-            final_cmd += item->value(
-                        tmpstr, "").toString().replace("%a", widget->text());
-        }
-        else if(type_string == "list")
-        {
-            // list type, use "value/n", n is the selected index of the
-            // combobox
+    if(!new_widget)
+        return;
+
+    ItemDelegate::setWidgetValue(
+                new_widget, item, index.data(ItemDelegate::ROLE_VALUE));
+    new_widget->setEnabled(isItemEditable(item));
+    new_widget->setToolTip(validator->getMessage(item->number));
+    itemWidgetMapper->setMapping(new_widget, item->number);
+    ItemDelegate::connectWidgetChanged(
+                new_widget, item, itemWidgetMapper, SLOT(map()));
+    view->setIndexWidget(index, new_widget);
+}
+
+/*
+ * copy the value of the widget of an item to the model
+ */
+void MainWindow::onItemWidgetChanged(int number)
+{
+    const Global::Item* item = global->getItems()->at(number);
+    QModelIndex index = model.mainTableModels[item->tabpage]->index(
+                item->row, COLUMN_VALUE);
+    QWidget* widget = ui.mainTableViews[item->tabpage]->indexWidget(index);
+
+    if(widget)
+        model.mainTableModels[item->tabpage]->setData(
+                    index, ItemDelegate::getWidgetValue(widget, item),
+                    ItemDelegate::ROLE_VALUE);
+}
 
-            QString tmpstr("value/");
-            QComboBox* widget = qobject_cast<QComboBox*>(
-                        ui.mainTableViews[tabpage]->indexWidget(
-                            model.mainTableModels[tabpage]->index(
-                                row, COLUMN_VALUE)));
+/*
+ * update the preview of the command when values in the models are changed
+ */
+void MainWindow::onMainTableModelsDataChanged(const QModelIndex& top_left,
+                                              const QModelIndex& bottom_right)
+{
+    // the whole preview is updated after a reload, and the states of the
+    // items don't change their values
+    if(reloading || updatingStates)
+        return;
 
-            tmpstr += QString::number(widget->currentIndex());
+    if(top_left.column() > COLUMN_VALUE || bottom_right.column() < COLUMN_VALUE)
+        return;
 
-            final_cmd += " ";
-            final_cmd += item->value(tmpstr, "").toString();
-        }
-        else if(type_string == "file")
+    const QList<Global::Item*>* items = global->getItems();
+
+    for(int row = top_left.row(); row <= bottom_right.row(); ++row)
+    {
+        QModelIndex index = top_left.sibling(row, COLUMN_VALUE);
+        bool ok = false;
+        int number = index.data(ItemDelegate::ROLE_ITEM).toInt(&ok);
+
+        if(!ok || number < 0 || number >= items->count())
+            continue;
+
+        // typing is debounced, other changes are displayed at once
+        QVariant value(index.data(ItemDelegate::ROLE_VALUE));
+        Global::Item::Type type = items->at(number)->type;
+        bool typed = type == Global::Item::TYPE_TEXT ||
+                type == Global::Item::TYPE_FILE;
+        ui.commandPreview->setValue(number, value, typed);
+        validator->setValue(number, value, typed);
+
+        // only the items whose conditions depend on this one are evaluated
+        QList<int> changed;
+        conditions.setValue(number, value, &changed);
+        Q_FOREACH(int changed_number, changed)
         {
-            // file type, if it is empty, use "value/empty", otherwise use
-            // "value/nonempty", and replace "%a" with the text in the
-            // lineedit
-
-            QString tmpstr("value/");
-            FileSelector* widget = qobject_cast<FileSelector*>(
-                        ui.mainTableViews[tabpage]->indexWidget(
-                            model.mainTableModels[tabpage]->index(
-                                row, COLUMN_VALUE)));
-
-            // if the field must be filled but it's empty, ask the user to
-            // fill it
-            if(item->value("mustnotempty", false).toBool() &&
-                    widget->getLineEdit()->text().isEmpty())
-            {
-                QMessageBox::information(
-                            this,
-                            QObject::tr(""),
-                            QObject::tr("Some fields must not be empty."));
+            const Global::Item* item = items->at(changed_number);
+            applyItemState(item);
+            ui.commandPreview->setValue(changed_number, getItemValue(item));
+        }
+    }
+}
+
+/*
+ * whether the value of an item could be changed: its conditions are true and
+ * its entries are known
+ */
+bool MainWindow::isItemEditable(const Global::Item* item) const
+{
+    return conditions.isEnabled(item->number) &&
+            !pendingLists.contains(item);
+}
+
+/*
+ * use the cached entries of a "list-cmd" item, or show a placeholder until
+ * its command has finished. The command is run again if the entries are
+ * older than ListCommandCache::TTL.
+ */
+void MainWindow::setupDynamicList(const Global::Item* item)
+{
+    if(item->type != Global::Item::TYPE_LIST || item->listCmd.isEmpty())
+        return;
+
+    ListCommandCache* cache = ListCommandCache::getInstance();
+    QStringList entries;
+    bool fresh = false;
+
+    if(cache->lookup(item->listCmd, *global->getWorkingDir(), &entries,
+                     &fresh))
+        setDynamicList(item, entries);
+    else
+    {
+        pendingLists.insert(item);
+        global->setItemListPlaceholder(item->number,
+                                       QObject::tr("(loading...)"));
+        rebuildItemWidget(item);
+        applyItemState(item);
+        ui.commandPreview->setValue(item->number, getItemValue(item));
+    }
+
+    if(!fresh)
+        cache->request(item->listCmd, *global->getWorkingDir());
+}
+
+/*
+ * replace the entries of a list item. The selected entry stays selected if
+ * it is still there, otherwise the default entry is selected.
+ */
+void MainWindow::setDynamicList(const Global::Item* item,
+                                const QStringList& entries)
+{
+    bool was_pending = pendingLists.remove(item);
+    QString selected(item->list.value(getItemValue(item).toInt()));
+
+    global->setItemList(item->number, entries);
+
+    int index = was_pending ? -1 : entries.indexOf(selected);
+    if(index < 0)
+    {
+        QVariant value(item->valueFromString(item->defaultValue));
+        index = value.isValid() ? value.toInt() : 0;
+    }
+
+    model.mainTableModels[item->tabpage]->setData(
+                model.mainTableModels[item->tabpage]->index(
+                    item->row, COLUMN_VALUE),
+                index, ItemDelegate::ROLE_VALUE);
+    rebuildItemWidget(item);
+    applyItemState(item);
+
+    // the fragment changes with the entries even if the index does not
+    ui.commandPreview->setValue(item->number, index);
+}
+
+/*
+ * create the editor of an item again after its entries have changed, if it
+ * has one. In the delegate render mode, the row is painted again.
+ */
+void MainWindow::rebuildItemWidget(const Global::Item* item)
+{
+    MainTableView* view = ui.mainTableViews[item->tabpage];
+    QModelIndex index = model.mainTableModels[item->tabpage]->index(
+                item->row, COLUMN_VALUE);
+    QWidget* widget = view->indexWidget(index);
+
+    if(!widget)
+    {
+        view->update(index);
+        return;
+    }
+
+    // the old editor is deleted by the view when it is replaced
+    itemWidgetMapper->removeMappings(widget);
+    createItemWidget(item);
+}
+
+void MainWindow::onListCommandReady(const QString& command,
+                                    const QString& working_dir)
+{
+    if(working_dir != *global->getWorkingDir())
+        return;
+
+    QStringList entries;
+    if(!ListCommandCache::getInstance()->lookup(command, working_dir,
+                                                &entries, NULL))
+        return;
+
+    Q_FOREACH(const Global::Item* item, *global->getItems())
+        if(item->type == Global::Item::TYPE_LIST && item->listCmd == command)
+            setDynamicList(item, entries);
+}
+
+/*
+ * the items still waiting for the command fall back to "list". Items which
+ * show cached entries keep them.
+ */
+void MainWindow::onListCommandFailed(const QString& command,
+                                     const QString& working_dir)
+{
+    if(working_dir != *global->getWorkingDir())
+        return;
+
+    Q_FOREACH(const Global::Item* item, pendingLists.toList())
+        if(item->listCmd == command)
+            setDynamicList(item, item->staticList);
+}
+
+/*
+ * disable or hide the row of an item according to its conditions
+ */
+void MainWindow::applyItemState(const Global::Item* item)
+{
+    QStandardItemModel* tmpmodel = model.mainTableModels[item->tabpage];
+    MainTableView* view = ui.mainTableViews[item->tabpage];
+    bool enabled = isItemEditable(item);
+
+    updatingStates = true;
+    tmpmodel->item(item->row, COLUMN_ITEM)->setEnabled(enabled);
+    tmpmodel->item(item->row, COLUMN_VALUE)->setEnabled(enabled);
+    updatingStates = false;
+
+    QWidget* widget = view->indexWidget(
+                tmpmodel->index(item->row, COLUMN_VALUE));
+    if(widget)
+        widget->setEnabled(enabled);
+
+    view->setRowHidden(item->row, !conditions.isVisible(item->number));
+}
+
+/*
+ * mark the row of an item whose value is invalid, the reason is shown as the
+ * tooltip
+ */
+void MainWindow::applyItemValidity(const Global::Item* item)
+{
+    QStandardItemModel* tmpmodel = model.mainTableModels[item->tabpage];
+    QString message(validator->getMessage(item->number));
+    QVariant foreground;
+    if(!message.isEmpty())
+        foreground = QBrush(Qt::red);
+
+    updatingStates = true;
+    tmpmodel->item(item->row, COLUMN_ITEM)->setData(
+                foreground, Qt::ForegroundRole);
+    tmpmodel->item(item->row, COLUMN_ITEM)->setToolTip(message);
+    tmpmodel->item(item->row, COLUMN_VALUE)->setToolTip(message);
+    updatingStates = false;
+
+    QWidget* widget = ui.mainTableViews[item->tabpage]->indexWidget(
+                tmpmodel->index(item->row, COLUMN_VALUE));
+    if(widget)
+        widget->setToolTip(message);
+}
+
+void MainWindow::onItemValidityChanged(int number)
+{
+    const QList<Global::Item*>* items = global->getItems();
+
+    if(!reloading && number >= 0 && number < items->count())
+        applyItemValidity(items->at(number));
+}
+
+/*
+ * get the current values of all items, indexed by Global::Item::number
+ */
+QVector<QVariant> MainWindow::getItemValues() const
+{
+    const QList<Global::Item*>* items = global->getItems();
+    QVector<QVariant> values(items->count());
+
+    Q_FOREACH(const Global::Item* item, *items)
+        values[item->number] = getItemValue(item);
+
+    return values;
+}
+
+/*
+ * get the current value of an item from the model
+ */
+QVariant MainWindow::getItemValue(const Global::Item* item) const
+{
+    return model.mainTableModels[item->tabpage]->index(
+                item->row, COLUMN_VALUE).data(ItemDelegate::ROLE_VALUE);
+}
+
+/*
+ * set the value of an item in the model, and in its widget if there is one
+ */
+void MainWindow::setItemValue(const Global::Item* item, const QVariant& value)
+{
+    QModelIndex index = model.mainTableModels[item->tabpage]->index(
+                item->row, COLUMN_VALUE);
+    QWidget* widget = ui.mainTableViews[item->tabpage]->indexWidget(index);
+
+    model.mainTableModels[item->tabpage]->setData(
+                index, value, ItemDelegate::ROLE_VALUE);
+    if(widget)
+        ItemDelegate::setWidgetValue(widget, item, value);
+}
+
+/*
+ * set the values of the items from a history entry. Items which were not in
+ * the cla file at that time, or whose value does not fit any more, keep
+ * their current values.
+ */
+void MainWindow::restoreValues(const QVariantMap& values)
+{
+    Q_FOREACH(const Global::Item* item, *global->getItems())
+    {
+        QVariantMap::const_iterator it = values.constFind(item->key);
 
-                selectItemOnMainTableViews(*item);
+        if(it == values.constEnd())
+            continue;
 
-                return;
+        QVariant value(item->fitValue(it.value()));
+        if(value.isValid())
+            setItemValue(item, value);
+    }
+}
+
+/*
+ * fill the history menu with the newest entries of the history
+ */
+void MainWindow::onHistoryMenuAboutToShow()
+{
+    QMenu* menu = qobject_cast<QMenu*>(QObject::sender());
+
+    if(!menu)
+        return;
+
+    menu->clear();
+    historyEntries = history.readRecent(HISTORY_MENU_SIZE);
+
+    QAction* action = menu->addAction(QObject::tr("Restore last run"));
+    action->setData(0);
+    action->setEnabled(!historyEntries.isEmpty());
+    menu->addSeparator();
+
+    for(int i = 0; i < historyEntries.count(); ++i)
+    {
+        const RunHistory::Entry& entry = historyEntries.at(i);
+        QString command(entry.command);
+        if(command.length() > 60)
+            command = command.left(57) + "...";
+
+        action = menu->addAction(
+                    entry.time.toString("yyyy-MM-dd hh:mm") + "  " + command);
+        action->setToolTip(entry.command);
+        action->setData(i);
+    }
+}
+
+void MainWindow::onHistoryMenuTriggered(QAction* action)
+{
+    bool ok = false;
+    int index = action->data().toInt(&ok);
+
+    if(ok && index >= 0 && index < historyEntries.count())
+        restoreValues(historyEntries.at(index).values);
+}
+
+/*
+ * build the first tab which has not been built, one tab at a time so that the
+ * event loop is not blocked for long
+ */
+void MainWindow::buildNextTab()
+{
+    int index = model.tabsBuilt.indexOf(false);
+
+    if(index < 0)
+        return;
+
+    buildTab(index);
+
+    QTimer::singleShot(0, this, SLOT(buildNextTab()));
+}
+
+/*
+ * add a tab with an empty table
+ */
+void MainWindow::addTab(const QString& name)
+{
+    QStandardItemModel* tmpmodel = createTableModel();
+    MainTableView*      tmpview = createTableView();
+    tmpview->setModel(tmpmodel);
+    if(useDelegates)
+    {
+        tmpview->setItemDelegateForColumn(COLUMN_VALUE, itemDelegate);
+        tmpview->setEditTriggers(QTableView::CurrentChanged |
+                                 QTableView::SelectedClicked |
+                                 QTableView::EditKeyPressed);
+    }
+    this->ui.mainTableViews.append(tmpview);
+    this->model.mainTableModels.append(tmpmodel);
+    QWidget* tmpwidget = new QWidget(this->ui.mainTabWidget);
+    QVBoxLayout* tmpvboxlayout = new QVBoxLayout();
+    tmpvboxlayout->addWidget(tmpview);
+    QLabel* tmplabel = new QLabel(tmpwidget);
+    tmpvboxlayout->addWidget(tmplabel);
+    this->ui.itemCountLabels.append(tmplabel);
+    tmpwidget->setLayout(tmpvboxlayout);
+    this->ui.mainTabWidget->addTab(tmpwidget, name);
+
+    connect(tmpview, SIGNAL(sizeChanged(QSize,QSize)),
+            SLOT(onMainTableViewsSizeChanged(QSize,QSize)));
+    connect(tmpmodel, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+            SLOT(onMainTableModelsDataChanged(QModelIndex,QModelIndex)));
+
+    this->model.itemsOfTabs.append(QList<const Global::Item*>());
+    this->model.tabsBuilt.append(useDelegates);
+}
+
+/*
+ * remove the last tab, which must be empty
+ */
+void MainWindow::removeLastTab()
+{
+    int tabpage = ui.mainTabWidget->count() - 1;
+    QWidget* page = ui.mainTabWidget->widget(tabpage);
+
+    ui.mainTabWidget->removeTab(tabpage);
+    delete page;
+    delete model.mainTableModels.takeLast();
+    ui.mainTableViews.removeLast();
+    ui.itemCountLabels.removeLast();
+    model.itemsOfTabs.removeLast();
+    model.tabsBuilt.removeLast();
+}
+
+void MainWindow::updateItemCountLabels()
+{
+    int tabcount = ui.itemCountLabels.count();
+    for(int i = 0; i < tabcount; ++i)
+        ui.itemCountLabels[i]->setText(
+                    QString::number(model.mainTableModels[i]->rowCount()) +
+                    QObject::tr(" item(s)."));
+}
+
+/*
+ * the items on each tab, sorted by "displayorder". Items whose tab does not
+ * exist are put on the first tab.
+ */
+QList<QList<const Global::Item*> > MainWindow::getItemsOfTabs() const
+{
+    QList<QList<const Global::Item*> > items_of_tabs;
+    for(int i = 0; i < ui.mainTabWidget->count(); ++i)
+        items_of_tabs.append(QList<const Global::Item*>());
+
+    QList<Global::Item*> items(*global->getItems());
+    {
+        ProfileScope profile("sort items by displayorder");
+        qSort(items.begin(), items.end(), Global::lessThanItemsDisplayorder);
+    }
+
+    Q_FOREACH(const Global::Item* item, items)
+    {
+        int tabpage = global->getTabs()->indexOf(item->tab);
+
+        if(tabpage < 0)
+            tabpage = 0;
+
+        items_of_tabs[tabpage].append(item);
+    }
+
+    return items_of_tabs;
+}
+
+/*
+ * the cells of the row of an item
+ */
+QList<QStandardItem*> MainWindow::createRow(const Global::Item* item,
+                                            const QVariant& value)
+{
+    QList<QStandardItem*> row;
+    QStandardItem* title_item = new QStandardItem(item->title);
+    title_item->setEditable(false);
+    QStandardItem* value_item = new QStandardItem();
+    value_item->setData(value, ItemDelegate::ROLE_VALUE);
+    value_item->setData(item->number, ItemDelegate::ROLE_ITEM);
+    row << title_item << value_item;
+
+    return row;
+}
+
+/*
+ * remove a row of a tab, keeping the value of its item in values
+ */
+void MainWindow::removeItemRow(int tabpage, int row,
+                               QHash<QString, QVariant>* values)
+{
+    QModelIndex index = model.mainTableModels[tabpage]->index(
+                row, COLUMN_VALUE);
+    QWidget* widget = ui.mainTableViews[tabpage]->indexWidget(index);
+    const Global::Item* item = model.itemsOfTabs[tabpage].takeAt(row);
+
+    values->insert(item->key, index.data(ItemDelegate::ROLE_VALUE));
+    if(widget)
+        itemWidgetMapper->removeMappings(widget);
+    model.mainTableModels[tabpage]->removeRow(row);
+}
+
+/*
+ * insert the row of an item into a tab, with its editor if the tab has been
+ * built
+ */
+void MainWindow::insertItemRow(int tabpage, int row,
+                               const Global::Item* item,
+                               const QVariant& value)
+{
+    global->setItemTabpageRow(item->number, tabpage, row);
+    model.mainTableModels[tabpage]->insertRow(row, createRow(item, value));
+    model.itemsOfTabs[tabpage].insert(row, item);
+
+    if(model.tabsBuilt[tabpage] && !useDelegates)
+        createItemWidget(item);
+}
+
+/*
+ * apply a new version of the cla file. Only the rows of the items which have
+ * been added, modified or moved are built again. The other rows, with their
+ * editors and values, are kept.
+ */
+void MainWindow::onConfReloaded()
+{
+    Global* conf = confReloader->takeConf();
+
+    if(!conf)
+        return;
+
+    ProfileScope profile("reload cla file");
+
+    QSet<QString> changed;
+    QList<Global::Item*> removed;
+    global->applyConf(conf, &changed, &removed);
+
+    QHash<QString, const Global::Item*> old_items;
+    Q_FOREACH(const Global::Item* item, removed)
+        old_items.insert(item->key, item);
+
+    reloading = true;
+
+    QStringList tab_names(*global->getTabs());
+    if(tab_names.empty())
+        tab_names.append(QObject::tr("All"));
+    int old_tab_count = ui.mainTabWidget->count();
+    for(int i = 0; i < tab_names.count(); ++i)
+    {
+        if(i < old_tab_count)
+            ui.mainTabWidget->setTabText(i, tab_names.at(i));
+        else
+            addTab(tab_names.at(i));
+    }
+
+    QList<QList<const Global::Item*> > items_of_tabs(getItemsOfTabs());
+    int tab_count = ui.mainTabWidget->count();
+
+    // first remove the rows of the items which are removed, modified or moved
+    // to another tab, so that their values are known when they are inserted
+    // again
+    QHash<QString, QVariant> values;
+    for(int tabpage = 0; tabpage < tab_count; ++tabpage)
+    {
+        QSet<const Global::Item*> kept(items_of_tabs.at(tabpage).toSet());
+        const QList<const Global::Item*>& rows = model.itemsOfTabs[tabpage];
+
+        for(int row = rows.count() - 1; row >= 0; --row)
+            if(!kept.contains(rows.at(row)))
+                removeItemRow(tabpage, row, &values);
+    }
+
+    // then insert the rows which are missing or out of order
+    for(int tabpage = 0; tabpage < tab_count; ++tabpage)
+    {
+        const QList<const Global::Item*>& new_rows =
+            items_of_tabs.at(tabpage);
+        const QList<const Global::Item*>& rows = model.itemsOfTabs[tabpage];
+
+        for(int row = 0; row < new_rows.count(); ++row)
+        {
+            const Global::Item* item = new_rows.at(row);
+
+            if(row < rows.count() && rows.at(row) == item)
+                continue;
+
+            // an item which is moved on the same tab
+            int old_row = rows.indexOf(item, row);
+            if(old_row >= 0)
+                removeItemRow(tabpage, old_row, &values);
+
+            // a value entered for the old definition of the item is kept if
+            // it still fits
+            QVariant value;
+            QHash<QString, QVariant>::const_iterator it =
+                values.constFind(item->key);
+            if(it != values.constEnd())
+            {
+                const Global::Item* old_item = old_items.value(item->key);
+                if(!old_item || it.value() != old_item->initialValue())
+                    value = item->fitValue(it.value());
             }
+            if(!value.isValid())
+                value = item->initialValue();
 
-            tmpstr += widget->getLineEdit()->text().isEmpty() ?
-                        "empty" : "nonempty";
+            insertItemRow(tabpage, row, item, value);
+        }
 
-            final_cmd += " ";
-            final_cmd += item->value(tmpstr, "").toString().replace(
-                        "%a", "\"" + widget->getLineEdit()->text() + "\"");
+        // the numbers of the items and the rows of the kept ones may have
+        // changed
+        QStandardItemModel* tmpmodel = model.mainTableModels[tabpage];
+        for(int row = 0; row < rows.count(); ++row)
+        {
+            const Global::Item* item = rows.at(row);
+            QModelIndex index = tmpmodel->index(row, COLUMN_VALUE);
+            QWidget* widget = ui.mainTableViews[tabpage]->indexWidget(index);
+
+            global->setItemTabpageRow(item->number, tabpage, row);
+            tmpmodel->setData(index, item->number, ItemDelegate::ROLE_ITEM);
+            if(widget)
+                itemWidgetMapper->setMapping(widget, item->number);
         }
     }
 
-    QString cmd_to_exec = Global::getInstance()->getTerminals()->at(
-                ui.termCombobox->currentIndex())->cmd + " " + final_cmd;
+    while(ui.mainTabWidget->count() > tab_names.count())
+        removeLastTab();
+
+    reloading = false;
+
+    // the conditions and the numbers they refer to may have changed
+    conditions.setValues(getItemValues());
+    validator->setValues(getItemValues());
+    Q_FOREACH(const Global::Item* item, *global->getItems())
+    {
+        applyItemState(item);
+        applyItemValidity(item);
+    }
+
+    // the new and modified "list-cmd" items are filled again
+    Q_FOREACH(const Global::Item* item, removed)
+        pendingLists.remove(item);
+    Q_FOREACH(const QString& key, changed)
+        setupDynamicList(global->getItem(key));
+
+    updateItemCountLabels();
+    setWindowTitle(*global->getWindowTitle() +
+                   "  --  " + QObject::tr("CmdLauncher"));
+    ui.commandPreview->setCommand(*global->getCommand());
+    ui.commandPreview->setValues(getItemValues());
+
+    Global::printText(stderr, QObject::tr("Reloaded ") +
+                      *global->getConfFile() + ", " +
+                      QString::number(changed.count()) +
+                      QObject::tr(" item(s) changed"));
+
+    qDeleteAll(removed);
+}
+
+/*
+ * fill the terminal combobox with the installed terminals. The index of each
+ * terminal in Global is kept as the item data. A terminal chosen by the user
+ * stays selected.
+ */
+void MainWindow::fillTermCombobox()
+{
+    QSet<QString> installed;
+    const QList<Global::Terminal*>* terminals = global->getTerminals();
+    QStringList programs;
+    Q_FOREACH(const Global::Terminal* term, *terminals)
+        programs.append(TerminalFinder::getProgram(term));
+    TerminalFinder::getInstance()->lookup(programs, &installed);
+
+    QVariant selected;
+    if(termChosen)
+        selected = ui.termCombobox->itemData(ui.termCombobox->currentIndex());
+
+    ui.termCombobox->clear();
+    for(int i = 0; i < terminals->count(); ++i)
+    {
+        // the internal console and "no terminal" are always available
+        if(programs[i].isEmpty() || installed.contains(programs[i]))
+            ui.termCombobox->addItem(terminals->at(i)->name, i);
+    }
+
+    if(selected.isValid())
+        ui.termCombobox->setCurrentIndex(
+                    qMax(0, ui.termCombobox->findData(selected)));
+}
+
+void MainWindow::onTermComboboxActivated()
+{
+    termChosen = true;
+}
+
+void MainWindow::onClickedButtonStart()
+{
+    // figure out the final command and run it. The values are read from the
+    // models, so that it does not matter whether the editors have been
+    // created.
+    const QList<Global::Item*>* items = global->getItems();
+    QVector<QVariant> values(getItemValues());
+
+    const Global::Item* empty_item = NULL;
+    const QString final_cmd(CommandBuilder::build(
+                                *global->getCommand(), *items,
+                                values, &empty_item,
+                                conditions.getActive()));
+
+    // if a field must be filled but it's empty, ask the user to fill it
+    if(empty_item)
+    {
+        QMessageBox::information(
+                    this,
+                    QObject::tr(""),
+                    QObject::tr("Some fields must not be empty."));
+
+        selectItemOnMainTableViews(*empty_item);
+
+        return;
+    }
+
+    // the values have been checked while they were edited, only the ones
+    // still being typed or looked up need to be waited for
+    validator->flush();
+    if(validator->isPending())
+    {
+        QMessageBox::information(
+                    this,
+                    QObject::tr(""),
+                    QObject::tr("Some fields are still being checked, "
+                                "please try again."));
+        return;
+    }
+    int invalid_number = validator->getFirstInvalid(conditions.getActive());
+    if(invalid_number >= 0)
+    {
+        const Global::Item* invalid_item = items->at(invalid_number);
+        QMessageBox::information(
+                    this,
+                    QObject::tr(""),
+                    invalid_item->title + ": " +
+                    validator->getMessage(invalid_number));
+
+        selectItemOnMainTableViews(*invalid_item);
 
-    Global::printText(stderr, QObject::tr("Executing ") + cmd_to_exec);
+        return;
+    }
+
+    // the command is started from its arguments, so that nothing needs to be
+    // quoted and split again
+    QStringList args(CommandBuilder::buildArguments(
+                         *global->getCommand(), *items,
+                         values, NULL, conditions.getActive()));
+    const Global::Terminal* term = global->getTerminals()->at(
+                ui.termCombobox->itemData(
+                    ui.termCombobox->currentIndex()).toInt());
+
+    // the command runs where cmdlauncher was started, which may not be the
+    // current directory of a daemon
+    QDir::setCurrent(*global->getWorkingDir());
+
+    // the window stays open, so that the command could be run again, e.g.
+    // with other values to compare the runs
+    bool started;
+    if(term->console)
+    {
+        Global::printText(stderr, QObject::tr("Executing ") + final_cmd);
+
+        // the console is a window of its own, which stays when the main
+        // window is closed
+        ConsoleWindow* console = new ConsoleWindow(
+                    args, *global->getWorkingDir(),
+                    *global->getRedirections());
+        console->setAttribute(Qt::WA_DeleteOnClose);
+        started = console->start();
+        if(started)
+            console->show();
+        else
+            delete console;
+    }
+    else
+    {
+        // the terminal, if any, is started as a child too, so that the job
+        // panel could follow it
+        Spawner::Redirections redirections;
+        QString job_cmd(final_cmd);
+        QString job_terminal;
+        if(term->cmd.isEmpty())
+            redirections = *global->getRedirections();
+        else
+        {
+            args = CommandBuilder::splitCommand(term->cmd) + args;
+            job_cmd = term->cmd + " " + final_cmd;
+            job_terminal = term->name;
+        }
+        Global::printText(stderr, QObject::tr("Executing ") + job_cmd);
+
+        QString error;
+        qint64 pid = Spawner::spawn(args, redirections, &error);
+        started = pid > 0;
+        if(started)
+        {
+            // the child is reaped by JobManager, which outlives the window,
+            // so that a daemon does not collect zombies
+            ui.jobPanel->addJob(JobManager::getInstance()->addJob(
+                                    pid, job_cmd, job_terminal));
+            ui.jobPanel->show();
+        }
+        else
+            Global::printText(stderr, error);
+    }
 
-    if(!QProcess::startDetached(cmd_to_exec))
+    if(!started)
     {
         QMessageBox::information(
                     this, "CmdLauncher",
@@ -339,7 +1111,16 @@ void MainWindow::onClickedButtonStart()
         return;
     }
 
-    exit(0);
+    // remember the values, so that they could be restored next time
+    RunHistory::Entry entry;
+    entry.time = QDateTime::currentDateTime();
+    entry.command = final_cmd;
+    Q_FOREACH(const Global::Item* item, *items)
+        entry.values.insert(item->key, values.at(item->number));
+    if(!history.append(entry))
+        Global::printText(stderr, QObject::tr(
+                    "[WARNING] Unable to write the history of ") +
+                *global->getConfFile());
 }
 
 MainTableView* MainWindow::createTableView()
@@ -382,7 +1163,7 @@ void MainWindow::onClickedButtonAbout()
 
     QMenu popup(this);
 
-    const Global::About* a = Global::getInstance()->getAbout();
+    const Global::About* a = global->getAbout();
     if(!a->name.isEmpty())
         popup.addAction(QObject::tr("About ") + a->name + QObject::tr("..."),
                         this, SLOT(onClickedMenuItemAboutApp()));
@@ -399,7 +1180,7 @@ void MainWindow::onClickedButtonAbout()
 // about the Application menu item slot function
 void MainWindow::onClickedMenuItemAboutApp()
 {
-    const Global::About* a = Global::getInstance()->getAbout();
+    const Global::About* a = global->getAbout();
 
     AboutDialog(this,
                 a->name,
@@ -450,7 +1231,48 @@ void MainWindow::onMainTableViewsSizeChanged(QSize old_size, QSize new_size)
  */
 void MainWindow::selectItemOnMainTableViews(const Global::Item& item)
 {
-    int tabpage = item.value("tabpage", 0).toInt();
-    ui.mainTabWidget->setCurrentIndex(tabpage);
-    ui.mainTableViews[tabpage]->selectRow(item.value("row").toInt());
+    ui.mainTabWidget->setCurrentIndex(item.tabpage);
+    ui.mainTableViews[item.tabpage]->selectRow(item.row);
+}
+
+/*
+ * select the item at position in the results of the search text, counting
+ * from the first result again after the last one. Hidden items are skipped.
+ */
+void MainWindow::showSearchResult(int position)
+{
+    const QList<Global::Item*>* items = global->getItems();
+    QList<int> results;
+
+    Q_FOREACH(int number, global->searchItems(ui.searchLineEdit->text()))
+        if(conditions.isVisible(number))
+            results.append(number);
+
+    if(results.isEmpty())
+    {
+        searchPosition = 0;
+        if(ui.searchLineEdit->text().trimmed().isEmpty())
+            ui.searchResultLabel->clear();
+        else
+            ui.searchResultLabel->setText(QObject::tr("No match"));
+        return;
+    }
+
+    searchPosition = position % results.count();
+    selectItemOnMainTableViews(*items->at(results.at(searchPosition)));
+    ui.searchResultLabel->setText(QString::number(searchPosition + 1) + "/" +
+                                  QString::number(results.count()));
+}
+
+void MainWindow::onSearchTextChanged()
+{
+    showSearchResult(0);
+}
+
+/*
+ * go to the next match
+ */
+void MainWindow::onSearchReturnPressed()
+{
+    showSearchResult(searchPosition + 1);
 }
@@ -23,13 +23,27 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QAction>
 #include <QComboBox>
+#include <QHash>
+#include <QLabel>
+#include <QLineEdit>
 #include <QList>
+#include <QSet>
+#include <QSignalMapper>
 #include <QStandardItemModel>
 #include <QTabWidget>
+#include <QVector>
 #include <QWidget>
+#include "commandpreview.h"
+#include "confreloader.h"
 #include "global.h"
+#include "itemconditions.h"
+#include "itemdelegate.h"
+#include "itemvalidator.h"
+#include "jobpanel.h"
 #include "maintableview.h"
+#include "runhistory.h"
 
 class MainWindow : public QWidget
 {
@@ -37,14 +51,23 @@ class MainWindow : public QWidget
 private:
     struct UI
     {
+        QLineEdit*              searchLineEdit;
+        QLabel*                 searchResultLabel;
         QTabWidget*             mainTabWidget;
         QList<MainTableView*>   mainTableViews;
+        QList<QLabel*>          itemCountLabels;
         QComboBox*              termCombobox;
+        CommandPreview*         commandPreview;
+        JobPanel*               jobPanel;
     } ui;
 
     struct MODEL
     {
         QList<QStandardItemModel*> mainTableModels;
+        // items on each tab, in the order of the rows
+        QList<QList<const Global::Item*> > itemsOfTabs;
+        // whether the editors on each tab have been created
+        QList<bool> tabsBuilt;
     } model;
 
     enum // table columns
@@ -54,16 +77,89 @@ private:
         COLUMN_COUNT
     };
 
+    // above this number of items, the delegate render mode is used
+    static const int DELEGATE_THRESHOLD = 500;
+
+    Global* global;
+    RunHistory history;
+    ItemConditions conditions;
+    ItemValidator* validator;
+    // "list-cmd" items whose commands have not finished yet
+    QSet<const Global::Item*> pendingLists;
+    // the entries shown in the history menu, newest first
+    QList<RunHistory::Entry> historyEntries;
+    // number of entries in the history menu
+    static const int HISTORY_MENU_SIZE = 20;
+
+    // the position of the selected item in the search results
+    int searchPosition;
+
+    // whether a terminal has been chosen in the combobox by the user
+    bool termChosen;
+
+    // parses the cla file again when it is modified
+    ConfReloader* confReloader;
+
+    bool useDelegates;
+    bool firstPainted;
+    bool reloading; // the rows are being updated after a reload
+    bool updatingStates; // the rows are being disabled or enabled
+    ItemDelegate* itemDelegate;
+    QSignalMapper* itemWidgetMapper;
+
     MainTableView* createTableView();
+    void addTab(const QString& name);
+    void removeLastTab();
+    void updateItemCountLabels();
+    QList<QList<const Global::Item*> > getItemsOfTabs() const;
+    QList<QStandardItem*> createRow(const Global::Item* item,
+                                    const QVariant& value);
+    void createItemWidget(const Global::Item* item);
+    void applyItemState(const Global::Item* item);
+    void applyItemValidity(const Global::Item* item);
+    bool isItemEditable(const Global::Item* item) const;
+    void setupDynamicList(const Global::Item* item);
+    void setDynamicList(const Global::Item* item, const QStringList& entries);
+    void rebuildItemWidget(const Global::Item* item);
+    void removeItemRow(int tabpage, int row,
+                       QHash<QString, QVariant>* values);
+    void insertItemRow(int tabpage, int row, const Global::Item* item,
+                       const QVariant& value);
+    QVariant getItemValue(const Global::Item* item) const;
+    QVector<QVariant> getItemValues() const;
+    void setItemValue(const Global::Item* item, const QVariant& value);
+    void restoreValues(const QVariantMap& values);
     QStandardItemModel* createTableModel();
     void selectItemOnMainTableViews(const Global::Item& item);
+    void showSearchResult(int position);
 
 public:
-    MainWindow(QWidget *parent = NULL);
+    MainWindow(Global* global, QWidget *parent = NULL);
     ~MainWindow();
 
+protected:
+    void paintEvent(QPaintEvent* event);
+    void showEvent(QShowEvent* event);
+
 private Q_SLOTS:
+    void buildTab(int tabpage);
+    void buildNextTab();
+    void onItemWidgetChanged(int number);
+    void onMainTableModelsDataChanged(const QModelIndex& top_left,
+                                      const QModelIndex& bottom_right);
+    void onItemValidityChanged(int number);
+    void fillTermCombobox();
+    void onTermComboboxActivated();
+    void onSearchTextChanged();
+    void onSearchReturnPressed();
+    void onConfReloaded();
+    void onListCommandReady(const QString& command,
+                            const QString& working_dir);
+    void onListCommandFailed(const QString& command,
+                             const QString& working_dir);
     void onClickedButtonStart();
+    void onHistoryMenuAboutToShow();
+    void onHistoryMenuTriggered(QAction* action);
     void onClickedButtonAbout();
     void onClickedMenuItemAboutApp();
     void onClickedMenuItemAboutCmdLauncher();
@@ -0,0 +1,156 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pathcompleter.h"
+#include "dirlister.h"
+#include <QDir>
+
+PathCompleter::PathCompleter(QLineEdit* line_edit) :
+    QCompleter(line_edit),
+    lineEdit(line_edit),
+    dirsOnly(false)
+{
+    listModel = new QStringListModel(this);
+    setModel(listModel);
+    setModelSorting(QCompleter::CaseSensitivelySortedModel);
+
+    connect(DirLister::getInstance(), SIGNAL(ready(QString)),
+            SLOT(onListingReady(QString)));
+}
+
+void PathCompleter::setDir(const QString& dir)
+{
+    baseDir = dir;
+    listedDir.clear();
+}
+
+/*
+ * filter is a filter of QFileDialog, e.g. "Images (*.png *.jpg);;Any (*)"
+ */
+void PathCompleter::setFilter(const QString& filter)
+{
+    QRegExp parenthesized("\\(([^)]*)\\)");
+
+    patterns.clear();
+    Q_FOREACH(const QString& f, filter.split(";;", QString::SkipEmptyParts))
+    {
+        QString names(f);
+        if(parenthesized.indexIn(f) >= 0)
+            names = parenthesized.cap(1);
+
+        Q_FOREACH(const QString& name,
+                  names.split(' ', QString::SkipEmptyParts))
+        {
+            // any file could be completed
+            if(name == "*")
+            {
+                patterns.clear();
+                listedDir.clear();
+                return;
+            }
+            patterns.append(QRegExp(name, Qt::CaseSensitive,
+                                    QRegExp::Wildcard));
+        }
+    }
+
+    listedDir.clear();
+}
+
+void PathCompleter::setDirsOnly(bool dirs_only)
+{
+    dirsOnly = dirs_only;
+    listedDir.clear();
+}
+
+/*
+ * called when the text is edited: show the listing of the directory being
+ * typed, or request it if it is not known yet
+ */
+void PathCompleter::update(const QString& text)
+{
+    QString path(QDir::fromNativeSeparators(text));
+    QString prefix(path.left(path.lastIndexOf('/') + 1));
+    QString dir(prefix);
+
+    if(!QDir::isAbsolutePath(dir))
+        dir = QDir(baseDir.isEmpty() ? QDir::currentPath() : baseDir)
+            .filePath(dir);
+    dir = QDir::cleanPath(dir);
+
+    if(dir == listedDir && prefix == listedPrefix)
+        return;
+
+    listedDir = dir;
+    listedPrefix = prefix;
+
+    QStringList entries;
+    if(DirLister::getInstance()->lookup(dir, &entries))
+        fillModel(entries);
+    else
+    {
+        listModel->setStringList(QStringList());
+        DirLister::getInstance()->request(dir);
+    }
+}
+
+void PathCompleter::onListingReady(const QString& dir)
+{
+    QStringList entries;
+
+    if(dir != listedDir || !DirLister::getInstance()->lookup(dir, &entries))
+        return;
+
+    fillModel(entries);
+}
+
+void PathCompleter::fillModel(const QStringList& entries)
+{
+    const QString prefix(QDir::toNativeSeparators(listedPrefix));
+    QStringList completions;
+    completions.reserve(entries.size());
+
+    Q_FOREACH(const QString& entry, entries)
+    {
+        if(!entry.endsWith('/'))
+        {
+            if(dirsOnly)
+                continue;
+
+            bool matched = patterns.isEmpty();
+            for(int i = 0; !matched && i < patterns.size(); ++i)
+                matched = patterns[i].exactMatch(entry);
+            if(!matched)
+                continue;
+        }
+
+        completions.append(prefix + entry);
+    }
+
+    listModel->setStringList(completions);
+
+    // the listing may arrive after the completer has looked at the model
+    if(lineEdit->hasFocus() && !lineEdit->text().isEmpty())
+    {
+        setCompletionPrefix(lineEdit->text());
+        complete();
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATHCOMPLETER_H
+#define PATHCOMPLETER_H
+
+#include <QCompleter>
+#include <QLineEdit>
+#include <QList>
+#include <QRegExp>
+#include <QStringListModel>
+
+// complete the path typed in a line edit from the listings of DirLister,
+// so that typing never waits for the file system
+class PathCompleter : public QCompleter
+{
+    Q_OBJECT
+public:
+    PathCompleter(QLineEdit* line_edit);
+
+    void setDir(const QString& dir);
+    void setFilter(const QString& filter);
+    void setDirsOnly(bool dirs_only);
+
+public Q_SLOTS:
+    void update(const QString& text);
+
+private Q_SLOTS:
+    void onListingReady(const QString& dir);
+
+private:
+    QLineEdit* lineEdit;
+    QStringListModel* listModel;
+
+    // relative paths are relative to this directory
+    QString baseDir;
+    // name patterns of the files which are completed, empty for any file
+    QList<QRegExp> patterns;
+    bool dirsOnly;
+
+    // the directory listed in the model, and the typed text before the file
+    // name
+    QString listedDir;
+    QString listedPrefix;
+
+    void fillModel(const QStringList& entries);
+};
+
+#endif // PATHCOMPLETER_H
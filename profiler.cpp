@@ -0,0 +1,169 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <QTextStream>
+#include <cstdio>
+#include "global.h"
+
+struct Phase
+{
+    QString name;
+    qint64 start; // in nanoseconds since the profiler is enabled
+    qint64 end;
+};
+
+static bool enabled = false;
+static bool reported = false;
+static QString outputFile;
+static QElapsedTimer timer;
+static QList<Phase> phases;
+// phases are recorded by worker threads too, e.g. when the cla file is
+// reloaded, so that the list and reported are only used with the lock held
+static QMutex mutex;
+
+/*
+ * start profiling. The report is written to output_file as JSON, or printed
+ * to stderr as a table if output_file is empty.
+ */
+void Profiler::enable(const QString& output_file)
+{
+    enabled = true;
+    outputFile = output_file;
+    timer.start();
+}
+
+bool Profiler::isEnabled()
+{
+    return enabled;
+}
+
+qint64 Profiler::elapsed()
+{
+    return enabled ? timer.nsecsElapsed() : 0;
+}
+
+void Profiler::record(const QString& name, qint64 start_ns, qint64 end_ns)
+{
+    if(!enabled)
+        return;
+
+    // nothing is recorded after the report
+    QMutexLocker locker(&mutex);
+    if(reported)
+        return;
+
+    Phase phase;
+    phase.name = name;
+    phase.start = start_ns;
+    phase.end = end_ns;
+    phases.append(phase);
+}
+
+/*
+ * record a point in time, e.g. the first paint of the main window
+ */
+void Profiler::mark(const QString& name)
+{
+    qint64 now = elapsed();
+    record(name, now, now);
+}
+
+/*
+ * write the report of the recorded phases, only once
+ */
+void Profiler::report()
+{
+    if(!enabled)
+        return;
+
+    QMutexLocker locker(&mutex);
+    if(reported)
+        return;
+
+    reported = true;
+    qint64 total = timer.nsecsElapsed();
+
+    if(outputFile.isEmpty())
+    {
+        QTextStream out(stderr);
+        out << QString("%1 %2 %3\n").arg(QObject::tr("phase"), -40)
+               .arg(QObject::tr("start ms"), 10)
+               .arg(QObject::tr("duration ms"), 12);
+
+        Q_FOREACH(const Phase& phase, phases)
+            out << QString("%1 %2 %3\n").arg(phase.name, -40)
+                   .arg(phase.start / 1e6, 10, 'f', 3)
+                   .arg((phase.end - phase.start) / 1e6, 12, 'f', 3);
+
+        out << QString("%1 %2\n").arg(QObject::tr("total"), -40)
+               .arg(total / 1e6, 10, 'f', 3);
+        return;
+    }
+
+    QJsonArray json_phases;
+    Q_FOREACH(const Phase& phase, phases)
+    {
+        QJsonObject obj;
+        obj.insert("name", phase.name);
+        obj.insert("start_ms", phase.start / 1e6);
+        obj.insert("duration_ms", (phase.end - phase.start) / 1e6);
+        json_phases.append(obj);
+    }
+
+    QJsonObject root;
+    root.insert("phases", json_phases);
+    root.insert("total_ms", total / 1e6);
+
+    QFile f(outputFile);
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        Global::printText(stderr, QObject::tr("Unable to write ") +
+                          outputFile);
+        return;
+    }
+
+    f.write(QJsonDocument(root).toJson());
+}
+
+ProfileScope::ProfileScope(const QString& name) :
+    start(Profiler::elapsed())
+{
+    // avoid copying the name when the profiler is disabled
+    if(Profiler::isEnabled())
+        this->name = name;
+}
+
+ProfileScope::~ProfileScope()
+{
+    if(Profiler::isEnabled())
+        Profiler::record(name, start, Profiler::elapsed());
+}
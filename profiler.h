@@ -0,0 +1,53 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+
+// a small facility to measure the phases of startup, enabled by
+// --profile-startup. When it is not enabled, measuring costs almost nothing.
+class Profiler
+{
+public:
+    static void enable(const QString& output_file = QString());
+    static bool isEnabled();
+    static void record(const QString& name, qint64 start_ns, qint64 end_ns);
+    static void mark(const QString& name);
+    static qint64 elapsed();
+    static void report();
+};
+
+// measure the time from its construction to its destruction
+class ProfileScope
+{
+public:
+    ProfileScope(const QString& name);
+    ~ProfileScope();
+
+private:
+    QString name;
+    qint64 start;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,233 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runhistory.h"
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QtEndian>
+
+// bump LOG_VERSION whenever the layout of the records changes
+static const quint32 LOG_MAGIC = 0x434c4148; // "CLAH"
+static const quint32 LOG_VERSION = 1;
+static const int HEADER_SIZE = 2 * sizeof(quint32);
+static const int LENGTH_SIZE = sizeof(quint32);
+
+// held while the log is written, so that a record appended by the GUI thread
+// is not lost when a compaction replaces the file
+static QMutex logMutex;
+
+// the compaction performed on the thread pool
+class CompactTask : public QRunnable
+{
+public:
+    CompactTask(const QString& log_file) :
+        logFile(log_file)
+    {
+    }
+
+    void run()
+    {
+        RunHistory::compact(logFile);
+    }
+
+private:
+    QString logFile;
+};
+
+static QByteArray encodeRecord(const RunHistory::Entry& entry)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << entry.time.toMSecsSinceEpoch() << entry.command << entry.values;
+
+    uchar length[LENGTH_SIZE];
+    qToBigEndian<quint32>(payload.size(), length);
+
+    QByteArray record;
+    record.reserve(payload.size() + 2 * LENGTH_SIZE);
+    record.append(reinterpret_cast<const char*>(length), LENGTH_SIZE);
+    record.append(payload);
+    record.append(reinterpret_cast<const char*>(length), LENGTH_SIZE);
+
+    return record;
+}
+
+static QByteArray encodeHeader()
+{
+    uchar header[HEADER_SIZE];
+    qToBigEndian<quint32>(LOG_MAGIC, header);
+    qToBigEndian<quint32>(LOG_VERSION, header + LENGTH_SIZE);
+
+    return QByteArray(reinterpret_cast<const char*>(header), HEADER_SIZE);
+}
+
+RunHistory::RunHistory(const QString& conf_file) :
+    logFile(getLogFile(conf_file))
+{
+}
+
+/*
+ * append an entry to the log, creating it if needed
+ */
+bool RunHistory::append(const RunHistory::Entry& entry)
+{
+    if(!QDir().mkpath(QFileInfo(logFile).absolutePath()))
+        return false;
+
+    QMutexLocker locker(&logMutex);
+    QFile f(logFile);
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Append))
+        return false;
+
+    // a single write, so that a crash leaves at most a truncated record at
+    // the end, which readRecent() skips
+    QByteArray data;
+    if(f.size() == 0)
+        data = encodeHeader();
+    data += encodeRecord(entry);
+
+    return f.write(data) == data.size();
+}
+
+QList<RunHistory::Entry> RunHistory::readRecent(int count) const
+{
+    return readRecent(logFile, count);
+}
+
+/*
+ * read the count newest entries of the log, newest first. The records are
+ * read backwards from the end of the mapped file. Truncated or damaged
+ * records, e.g. left by a crash in append(), are skipped.
+ */
+QList<RunHistory::Entry> RunHistory::readRecent(const QString& log_file,
+                                                int count)
+{
+    QList<Entry> entries;
+    QFile f(log_file);
+
+    if(!f.open(QIODevice::ReadOnly) || f.size() < HEADER_SIZE)
+        return entries;
+
+    qint64 size = f.size();
+    const uchar* data = f.map(0, size);
+    if(!data)
+        return entries;
+
+    if(qFromBigEndian<quint32>(data) != LOG_MAGIC ||
+            qFromBigEndian<quint32>(data + LENGTH_SIZE) != LOG_VERSION)
+        return entries;
+
+    // when the lengths before end don't match or the record can't be
+    // decoded, the bytes before end are not the end of a record: the end of
+    // the previous valid record is looked for one byte earlier
+    qint64 end = size;
+    while(end - 2 * LENGTH_SIZE >= HEADER_SIZE && entries.size() < count)
+    {
+        quint32 length = qFromBigEndian<quint32>(data + end - LENGTH_SIZE);
+        qint64 begin = end - 2 * LENGTH_SIZE - qint64(length);
+
+        if(begin < HEADER_SIZE ||
+                qFromBigEndian<quint32>(data + begin) != length)
+        {
+            --end;
+            continue;
+        }
+
+        QByteArray payload(QByteArray::fromRawData(
+                reinterpret_cast<const char*>(data + begin + LENGTH_SIZE),
+                length));
+        QDataStream in(payload);
+        in.setVersion(QDataStream::Qt_5_0);
+
+        Entry entry;
+        qint64 msecs = 0;
+        in >> msecs >> entry.command >> entry.values;
+        if(in.status() != QDataStream::Ok || !in.atEnd())
+        {
+            --end;
+            continue;
+        }
+
+        entry.time = QDateTime::fromMSecsSinceEpoch(msecs);
+        entries.append(entry);
+        end = begin;
+    }
+
+    return entries;
+}
+
+/*
+ * compact the log on the thread pool if it is larger than MAX_SIZE
+ */
+void RunHistory::compactIfNeeded()
+{
+    if(QFileInfo(logFile).size() > MAX_SIZE)
+        QThreadPool::globalInstance()->start(new CompactTask(logFile));
+}
+
+/*
+ * rewrite the log with only its KEEP_ENTRIES newest entries. The log is
+ * locked meanwhile, so that append() waits for the new file.
+ */
+bool RunHistory::compact(const QString& log_file)
+{
+    QMutexLocker locker(&logMutex);
+    QList<Entry> entries(readRecent(log_file, KEEP_ENTRIES));
+
+    // a log without any readable record is left as it is
+    if(entries.isEmpty())
+        return false;
+
+    QSaveFile f(log_file);
+    if(!f.open(QIODevice::WriteOnly))
+        return false;
+
+    QByteArray data(encodeHeader());
+    for(int i = entries.size() - 1; i >= 0; --i)
+        data += encodeRecord(entries.at(i));
+
+    f.write(data);
+
+    return f.commit();
+}
+
+QString RunHistory::getLogFile(const QString& conf_file)
+{
+    QByteArray key(QCryptographicHash::hash(
+                       QFileInfo(conf_file).absoluteFilePath().toUtf8(),
+                       QCryptographicHash::Sha1).toHex());
+
+    return QStandardPaths::writableLocation(
+                QStandardPaths::GenericDataLocation) +
+            "/cmdlauncher/history/" + QString::fromLatin1(key) + ".clh";
+}
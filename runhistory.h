@@ -0,0 +1,66 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RUNHISTORY_H
+#define RUNHISTORY_H
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QVariantMap>
+
+// the values used in each run of a cla file, kept in an append-only log.
+// Each record is its length, the record, and its length again, so that the
+// newest records are read from the end of the mapped file without parsing
+// the older ones. The log is compacted on a worker thread once it grows
+// past MAX_SIZE.
+class RunHistory
+{
+public:
+    // the log is compacted when it is larger than this, in bytes
+    static const qint64 MAX_SIZE = 1024 * 1024;
+    // number of records kept by the compaction
+    static const int KEEP_ENTRIES = 200;
+
+    struct Entry
+    {
+        QDateTime time;
+        QString command;
+        QVariantMap values; // values of the items, by key
+    };
+
+    RunHistory(const QString& conf_file);
+
+    bool append(const RunHistory::Entry& entry);
+    QList<RunHistory::Entry> readRecent(int count) const;
+    void compactIfNeeded();
+
+    static QList<RunHistory::Entry> readRecent(const QString& log_file,
+                                               int count);
+    static bool compact(const QString& log_file);
+    static QString getLogFile(const QString& conf_file);
+
+private:
+    QString logFile;
+};
+
+#endif // RUNHISTORY_H
@@ -0,0 +1,126 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spawner.h"
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QVector>
+
+#ifdef Q_OS_UNIX
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+/*
+ * start a process whose program and arguments are given by arguments, and
+ * return its pid, or -1 on failure, in which case error is set. The program
+ * is looked up in PATH. The process is put into its own process group, so
+ * that it is not affected by signals sent to CmdLauncher's terminal, but it
+ * stays a child: the caller must reap the pid, otherwise it is left as a
+ * zombie once it exits. Elsewhere the process is started detached and there
+ * is nothing to reap.
+ */
+qint64 Spawner::spawn(const QStringList& arguments,
+                      const Spawner::Redirections& redirections,
+                      QString* error)
+{
+    if(arguments.isEmpty())
+    {
+        if(error)
+            *error = QObject::tr("Empty command");
+        return -1;
+    }
+
+#ifdef Q_OS_UNIX
+    // the encoded strings must be kept until posix_spawnp returns
+    QList<QByteArray> encoded;
+    Q_FOREACH(const QString& arg, arguments)
+        encoded.append(QFile::encodeName(arg));
+
+    QVector<char*> argv;
+    for(int i = 0; i < encoded.count(); ++i)
+        argv.append(encoded[i].data());
+    argv.append(NULL);
+
+    const QByteArray stdin_file(QFile::encodeName(redirections.stdinFile));
+    const QByteArray stdout_file(QFile::encodeName(redirections.stdoutFile));
+    const QByteArray stderr_file(QFile::encodeName(redirections.stderrFile));
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if(!stdin_file.isEmpty())
+        posix_spawn_file_actions_addopen(
+                    &actions, STDIN_FILENO, stdin_file.constData(),
+                    O_RDONLY, 0);
+    if(!stdout_file.isEmpty())
+        posix_spawn_file_actions_addopen(
+                    &actions, STDOUT_FILENO, stdout_file.constData(),
+                    O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(!stderr_file.isEmpty())
+        posix_spawn_file_actions_addopen(
+                    &actions, STDERR_FILENO, stderr_file.constData(),
+                    O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    pid_t pid = -1;
+    int ret = posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(),
+                           environ);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if(ret != 0)
+    {
+        if(error)
+            *error = QString::fromLocal8Bit(strerror(ret));
+        return -1;
+    }
+
+    return pid;
+#else
+    // redirections are not supported here
+    Q_UNUSED(redirections);
+
+    qint64 pid = -1;
+    if(!QProcess::startDetached(arguments.first(), arguments.mid(1),
+                                QString(), &pid))
+    {
+        if(error)
+            *error = QObject::tr("Failed to start ") + arguments.first();
+        return -1;
+    }
+
+    return pid;
+#endif
+}
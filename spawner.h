@@ -0,0 +1,51 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPAWNER_H
+#define SPAWNER_H
+
+#include <QString>
+#include <QStringList>
+
+// start a process from an argument vector directly, without a shell or a
+// terminal emulator. On UNIX-like systems posix_spawn is used, and the
+// process is a child of CmdLauncher which must be waited for, e.g. by
+// JobManager.
+class Spawner
+{
+public:
+    // files the standard streams of the process are redirected to. Empty
+    // means the stream is inherited.
+    struct Redirections
+    {
+        QString stdinFile;
+        QString stdoutFile;
+        QString stderrFile;
+    };
+
+    static qint64 spawn(const QStringList& arguments,
+                        const Spawner::Redirections& redirections =
+                        Spawner::Redirections(),
+                        QString* error = NULL);
+};
+
+#endif // SPAWNER_H
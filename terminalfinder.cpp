@@ -0,0 +1,273 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "terminalfinder.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include "commandbuilder.h"
+
+// bump CACHE_VERSION whenever the layout of the cache changes
+static const quint32 CACHE_MAGIC = 0x434c4154; // "CLAT"
+static const quint32 CACHE_VERSION = 1;
+
+static TerminalFinder* instance = NULL;
+
+// the search for the programs in one directory of PATH, performed on the
+// thread pool. Absolute paths of programs are checked with an empty dir.
+class TerminalSearchTask : public QRunnable
+{
+public:
+    TerminalSearchTask(TerminalFinder* finder, const QString& dir,
+                       const QStringList& programs) :
+        finder(finder), dir(dir), programs(programs)
+    {
+    }
+
+    void run()
+    {
+        QStringList found;
+
+        Q_FOREACH(const QString& program, programs)
+        {
+            QFileInfo fi(dir.isEmpty() ? program : dir + '/' + program);
+            if(fi.isFile() && fi.isExecutable())
+                found.append(program);
+        }
+
+        QMetaObject::invokeMethod(finder, "onDirectorySearched",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QStringList, found));
+    }
+
+private:
+    TerminalFinder* finder;
+    QString dir;
+    QStringList programs;
+};
+
+TerminalFinder::TerminalFinder() :
+    cacheRead(false),
+    pendingTasks(0)
+{
+}
+
+/*
+ * the instance lives until the end of the program, since tasks may still be
+ * running on the thread pool when it is no longer used
+ */
+TerminalFinder* TerminalFinder::getInstance()
+{
+    if(!instance)
+        instance = new TerminalFinder;
+
+    return instance;
+}
+
+/*
+ * get the program started by the terminal, empty if there is none
+ */
+QString TerminalFinder::getProgram(const Global::Terminal* term)
+{
+    return CommandBuilder::splitCommand(term->cmd).value(0);
+}
+
+/*
+ * get which of the programs are installed. Returns false if some of them
+ * have not been searched for yet, in which case find() should be called.
+ */
+bool TerminalFinder::lookup(const QStringList& programs,
+                            QSet<QString>* installed)
+{
+#ifdef Q_OS_WIN
+    // only the terminals that come with Windows are known
+    if(installed)
+        *installed = programs.toSet();
+
+    return true;
+#else
+    if(!cacheRead)
+        readCache();
+    updatePathState();
+
+    Q_FOREACH(const QString& program, programs)
+        if(!checked.contains(program))
+            return false;
+
+    if(installed)
+    {
+        installed->clear();
+        Q_FOREACH(const QString& program, programs)
+            if(this->installed.contains(program))
+                installed->insert(program);
+    }
+
+    return true;
+#endif
+}
+
+/*
+ * search for the programs which are not known yet, each directory of PATH
+ * in a task of its own. ready() is emitted when all of them are finished.
+ */
+void TerminalFinder::find(const QStringList& programs)
+{
+    QStringList relative, absolute;
+
+    Q_FOREACH(const QString& program, programs)
+    {
+        if(program.isEmpty() || checked.contains(program) ||
+                searching.contains(program))
+            continue;
+
+        searching.insert(program);
+        if(QDir::isAbsolutePath(program))
+            absolute.append(program);
+        else
+            relative.append(program);
+    }
+
+    if(!relative.isEmpty())
+    {
+        Q_FOREACH(const QString& dir,
+                  path.split(':', QString::SkipEmptyParts))
+        {
+            ++pendingTasks;
+            QThreadPool::globalInstance()->start(
+                        new TerminalSearchTask(this, dir, relative));
+        }
+    }
+
+    if(!absolute.isEmpty())
+    {
+        ++pendingTasks;
+        QThreadPool::globalInstance()->start(
+                    new TerminalSearchTask(this, QString(), absolute));
+    }
+
+    // nothing to search for, e.g. PATH is empty
+    if(pendingTasks == 0 && !searching.isEmpty())
+        onDirectorySearched(QStringList());
+}
+
+void TerminalFinder::onDirectorySearched(const QStringList& found)
+{
+    installed.unite(found.toSet());
+
+    if(pendingTasks > 0)
+        --pendingTasks;
+    if(pendingTasks > 0)
+        return;
+
+    checked.unite(searching);
+    searching.clear();
+    writeCache();
+
+    Q_EMIT ready();
+}
+
+/*
+ * forget what has been found if PATH or one of its directories has changed,
+ * e.g. because a terminal has been installed
+ */
+void TerminalFinder::updatePathState()
+{
+    QString current_path(QString::fromLocal8Bit(qgetenv("PATH")));
+    QList<qint64> mtimes;
+
+    Q_FOREACH(const QString& dir,
+              current_path.split(':', QString::SkipEmptyParts))
+        mtimes.append(QFileInfo(dir).lastModified().toMSecsSinceEpoch());
+
+    if(current_path == path && mtimes == pathMtimes)
+        return;
+
+    path = current_path;
+    pathMtimes = mtimes;
+    checked.clear();
+    installed.clear();
+}
+
+void TerminalFinder::readCache()
+{
+    cacheRead = true;
+
+    QFile f(getCacheFile());
+    if(!f.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if(magic != CACHE_MAGIC || version != CACHE_VERSION)
+        return;
+
+    QString cached_path;
+    QList<qint64> mtimes;
+    QStringList cached_checked, cached_installed;
+    in >> cached_path >> mtimes >> cached_checked >> cached_installed;
+    if(in.status() != QDataStream::Ok)
+        return;
+
+    path = cached_path;
+    pathMtimes = mtimes;
+    checked = cached_checked.toSet();
+    installed = cached_installed.toSet();
+}
+
+void TerminalFinder::writeCache()
+{
+    QString cache_file(getCacheFile());
+
+    if(!QDir().mkpath(QFileInfo(cache_file).absolutePath()))
+        return;
+
+    QSaveFile f(cache_file);
+    if(!f.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_0);
+
+    out << CACHE_MAGIC << CACHE_VERSION;
+    out << path << pathMtimes << QStringList(checked.toList())
+        << QStringList(installed.toList());
+
+    if(out.status() == QDataStream::Ok)
+        f.commit();
+}
+
+QString TerminalFinder::getCacheFile()
+{
+    return QStandardPaths::writableLocation(
+                QStandardPaths::GenericCacheLocation) +
+            "/cmdlauncher/terminals.clt";
+}
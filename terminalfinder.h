@@ -0,0 +1,75 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TERMINALFINDER_H
+#define TERMINALFINDER_H
+
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include "global.h"
+
+// find which terminal programs are installed. The directories in PATH are
+// searched in parallel on the thread pool, and the results are kept in a
+// cache file which stays valid as long as PATH and the modification times of
+// its directories don't change, so that later startups don't search at all.
+class TerminalFinder : public QObject
+{
+    Q_OBJECT
+public:
+    static TerminalFinder* getInstance();
+
+    static QString getProgram(const Global::Terminal* term);
+
+    bool lookup(const QStringList& programs, QSet<QString>* installed);
+    void find(const QStringList& programs);
+
+Q_SIGNALS:
+    // emitted in the GUI thread when a search is finished
+    void ready();
+
+private Q_SLOTS:
+    void onDirectorySearched(const QStringList& found);
+
+private:
+    TerminalFinder();
+
+    void updatePathState();
+    void readCache();
+    void writeCache();
+    static QString getCacheFile();
+
+    // PATH and the modification times of its directories when the results
+    // were found
+    QString path;
+    QList<qint64> pathMtimes;
+    bool cacheRead;
+
+    QSet<QString> checked; // programs searched for
+    QSet<QString> installed; // programs found, a subset of checked
+    QSet<QString> searching; // programs being searched for
+    int pendingTasks;
+};
+
+#endif // TERMINALFINDER_H
@@ -0,0 +1,219 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "valuetemplate.h"
+#include <QFileInfo>
+#include "commandbuilder.h"
+
+ValueTemplate::ValueTemplate() :
+    literalSize(0),
+    placeholderCount(0)
+{
+}
+
+/*
+ * compile source. If placeholders is false, source is taken literally.
+ */
+ValueTemplate::ValueTemplate(const QString& source, bool placeholders) :
+    segments(compile(source, placeholders)),
+    literalSize(0),
+    placeholderCount(0)
+{
+    // words are split before the placeholders are substituted, so that the
+    // text of the item never gets split
+    Q_FOREACH(const QString& word, CommandBuilder::splitCommand(source))
+        words.append(compile(word, placeholders));
+
+    Q_FOREACH(const Segment& segment, segments)
+    {
+        if(segment.kind == Segment::KIND_LITERAL)
+            literalSize += segment.text.size();
+        else
+            ++placeholderCount;
+    }
+}
+
+ValueTemplate::Segments ValueTemplate::compile(const QString& source,
+                                               bool placeholders)
+{
+    Segments result;
+    Segment segment;
+    QString literal;
+    int size = source.size();
+
+    for(int i = 0; i < size; ++i)
+    {
+        const QChar c = source.at(i);
+
+        if(!placeholders || c != '%' || i + 1 >= size)
+        {
+            literal += c;
+            continue;
+        }
+
+        switch(source.at(i + 1).unicode())
+        {
+        case 'a':
+            segment.kind = Segment::KIND_ARG;
+            break;
+        case 'q':
+            segment.kind = Segment::KIND_QUOTED_ARG;
+            break;
+        case 'b':
+            segment.kind = Segment::KIND_BASENAME;
+            break;
+        case 'd':
+            segment.kind = Segment::KIND_DIRNAME;
+            break;
+        case '%':
+            literal += '%';
+            ++i;
+            continue;
+        default:
+            literal += c;
+            continue;
+        }
+
+        ++i;
+
+        if(!literal.isEmpty())
+        {
+            Segment literal_segment;
+            literal_segment.kind = Segment::KIND_LITERAL;
+            literal_segment.text = literal;
+            result.append(literal_segment);
+            literal.clear();
+        }
+
+        result.append(segment);
+    }
+
+    if(!literal.isEmpty())
+    {
+        segment.kind = Segment::KIND_LITERAL;
+        segment.text = literal;
+        result.append(segment);
+    }
+
+    return result;
+}
+
+bool ValueTemplate::isEmpty() const
+{
+    return segments.isEmpty();
+}
+
+/*
+ * an estimation of the size of the template rendered with arg, used to
+ * reserve memory before rendering
+ */
+int ValueTemplate::sizeHint(const QString& arg) const
+{
+    return literalSize + placeholderCount * (arg.size() + 2);
+}
+
+/*
+ * render the template with arg and append it to out. If quote is true, the
+ * substitutions of %a, %b and %d are surrounded by double quotes.
+ */
+void ValueTemplate::appendTo(QString* out, const QString& arg,
+                             bool quote) const
+{
+    appendSegments(out, segments, arg, quote, true);
+}
+
+/*
+ * render the template with arg and append the words of it to out. No shell
+ * runs the arguments, so %q is the text as it is, like %a.
+ */
+void ValueTemplate::appendArguments(QStringList* out,
+                                    const QString& arg) const
+{
+    Q_FOREACH(const Segments& word, words)
+    {
+        QString tmpstr;
+        appendSegments(&tmpstr, word, arg, false, false);
+        out->append(tmpstr);
+    }
+}
+
+/*
+ * render segments with arg. %q is quoted for the shell only if shell is true.
+ */
+void ValueTemplate::appendSegments(QString* out, const Segments& segments,
+                                   const QString& arg, bool quote,
+                                   bool shell)
+{
+    Q_FOREACH(const Segment& segment, segments)
+    {
+        QString value;
+
+        switch(segment.kind)
+        {
+        case Segment::KIND_LITERAL:
+            out->append(segment.text);
+            continue;
+        case Segment::KIND_QUOTED_ARG:
+            out->append(shell ? shellQuote(arg) : arg);
+            continue;
+        case Segment::KIND_ARG:
+            value = arg;
+            break;
+        case Segment::KIND_BASENAME:
+            value = QFileInfo(arg).fileName();
+            break;
+        case Segment::KIND_DIRNAME:
+            value = QFileInfo(arg).path();
+            break;
+        }
+
+        if(quote)
+        {
+            out->append('"');
+            out->append(value);
+            out->append('"');
+        }
+        else
+            out->append(value);
+    }
+}
+
+/*
+ * quote str so that a POSIX shell takes it as one word
+ */
+QString ValueTemplate::shellQuote(const QString& str)
+{
+    if(str.isEmpty())
+        return "''";
+
+    bool safe = true;
+    for(int i = 0; i < str.size() && safe; ++i)
+    {
+        const QChar c = str.at(i);
+        safe = c.isLetterOrNumber() || QString("_@%+=:,./-").contains(c);
+    }
+
+    if(safe)
+        return str;
+
+    return "'" + QString(str).replace("'", "'\\''") + "'";
+}
@@ -0,0 +1,89 @@
+/*
+ * CmdLauncher
+ *
+ * Copyright (c) 2015 Hong Xu
+ *
+ *
+ * This file is part of CmdLauncher.
+ *
+ * CmdLauncher is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * CmdLauncher is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with CmdLauncher. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VALUETEMPLATE_H
+#define VALUETEMPLATE_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// a value template of an item, such as "value/nonempty", compiled into
+// literal and placeholder segments once, so that it can be rendered without
+// searching the template again. The placeholders are:
+//
+//   %a  the text of the item
+//   %q  the text of the item, quoted for POSIX shells. It is the same as
+//       %a in the arguments, which are not run by a shell.
+//   %b  the base name of the text of the item, i.e. without directory
+//   %d  the directory part of the text of the item
+//   %%  a literal "%"
+//
+// Any other "%" is kept as it is.
+class ValueTemplate
+{
+public:
+    ValueTemplate();
+    ValueTemplate(const QString& source, bool placeholders = true);
+
+    bool isEmpty() const;
+    int sizeHint(const QString& arg) const;
+    void appendTo(QString* out, const QString& arg = QString(),
+                  bool quote = false) const;
+    void appendArguments(QStringList* out,
+                         const QString& arg = QString()) const;
+
+    static QString shellQuote(const QString& str);
+
+private:
+    struct Segment
+    {
+        enum Kind
+        {
+            KIND_LITERAL = 0,
+            KIND_ARG, // %a
+            KIND_QUOTED_ARG, // %q
+            KIND_BASENAME, // %b
+            KIND_DIRNAME // %d
+        };
+
+        enum Kind kind;
+        QString text; // for KIND_LITERAL
+    };
+
+    typedef QVector<ValueTemplate::Segment> Segments;
+
+    // segments of the whole template, used when rendered as a string
+    Segments segments;
+    // segments of each word of the template, used when rendered as arguments
+    QList<ValueTemplate::Segments> words;
+    int literalSize;
+    int placeholderCount;
+
+    static Segments compile(const QString& source, bool placeholders);
+    static void appendSegments(QString* out, const Segments& segments,
+                               const QString& arg, bool quote,
+                               bool shell);
+};
+
+#endif // VALUETEMPLATE_H